@@ -15,11 +15,29 @@
 */
 
 #include <deque>
+#include <algorithm>
+#include <climits>
 #include <string>
-#include <numeric>
 #include <sstream>
 #include <stdexcept>
+#include <charconv>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <list>
+#include <unordered_map>
+#include <thread>
+#include <exception>
+#include <memory_resource>
 #include <iostream> // for testing only
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LE_SSE2
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(_MSC_VER)
+#define LE_AVX2
+#endif
+#endif
 #include "le.h"
 
 using namespace std;
@@ -39,591 +57,2926 @@ namespace LE{
     };
 
 
-    // split
+    // stats: with LE_STATS defined, every thread counts in its own block of
+    // relaxed atomics, so counting never waits, and stats() sums all the blocks
 
-    template <class ComaType> void do_split(vector<String>& To, String Line, ComaType Coma, size_t Coma_len){
-        size_t coma_pos = 0;
-        while(coma_pos != String::npos){
-            size_t new_coma_pos = Line.find(Coma, coma_pos);
-            if(new_coma_pos != String::npos){
-                To.push_back(Line.substr(coma_pos, new_coma_pos-coma_pos));
-                coma_pos = new_coma_pos+Coma_len;
-            }else{
-                To.push_back(Line.substr(coma_pos, String::npos));
-                coma_pos = String::npos;
-            }
+#ifdef LE_STATS
+
+    enum StatsFunction{stats_split, stats_join, stats_replace, stats_replace_all, stats_text, stats_calc, stats_calc_compile, stats_evaluate, stats_functions};
+    const char* const stats_names[stats_functions] = {"split", "join", "replace", "replace_all", "text", "calc", "calc_compile", "evaluate"};
+
+    struct StatsBlock{
+        atomic<size_t> calls[stats_functions] = {};
+        atomic<size_t> nanoseconds[stats_functions] = {};
+        atomic<size_t> bytes_in[stats_functions] = {};
+        atomic<size_t> bytes_out[stats_functions] = {};
+        atomic<size_t> numbers = {0};
+        atomic<size_t> digits = {0};
+        atomic<size_t> max_digits = {0};
+        atomic<size_t> operations[5] = {}; // as in CalcOp
+        atomic<size_t> max_depth = {0};
+        atomic<size_t> long_arithmetic = {0};
+    };
+
+    // only the owner thread writes, so there is no need for read-modify-write
+    void stats_add(atomic<size_t>& To, size_t N){
+        To.store(To.load(memory_order_relaxed) + N, memory_order_relaxed);
+    }
+
+    void stats_max(atomic<size_t>& To, size_t N){
+        if(N > To.load(memory_order_relaxed)){
+            To.store(N, memory_order_relaxed);
         }
     }
 
-    vector<String> split(const String& Line, const Char Coma){
-        vector<String> ret;
-        do_split<Char>(ret, Line, Coma, 1);
-        return ret;
+    void stats_merge(StatsBlock& To, const StatsBlock& From){
+        for(size_t i = 0; i < stats_functions; i++){
+            stats_add(To.calls[i], From.calls[i].load(memory_order_relaxed));
+            stats_add(To.nanoseconds[i], From.nanoseconds[i].load(memory_order_relaxed));
+            stats_add(To.bytes_in[i], From.bytes_in[i].load(memory_order_relaxed));
+            stats_add(To.bytes_out[i], From.bytes_out[i].load(memory_order_relaxed));
+        }
+        stats_add(To.numbers, From.numbers.load(memory_order_relaxed));
+        stats_add(To.digits, From.digits.load(memory_order_relaxed));
+        stats_max(To.max_digits, From.max_digits.load(memory_order_relaxed));
+        for(size_t i = 0; i < 5; i++){
+            stats_add(To.operations[i], From.operations[i].load(memory_order_relaxed));
+        }
+        stats_max(To.max_depth, From.max_depth.load(memory_order_relaxed));
+        stats_add(To.long_arithmetic, From.long_arithmetic.load(memory_order_relaxed));
     }
 
-    vector<String> split(const String& Line, const String& Coma){
-        vector<String> ret;
-        do_split<String>(ret, Line, Coma, Coma.length());
-        return ret;
+    void stats_clear(StatsBlock& Block){
+        for(size_t i = 0; i < stats_functions; i++){
+            Block.calls[i] = Block.nanoseconds[i] = Block.bytes_in[i] = Block.bytes_out[i] = 0;
+        }
+        Block.numbers = Block.digits = Block.max_digits = Block.max_depth = Block.long_arithmetic = 0;
+        for(size_t i = 0; i < 5; i++){
+            Block.operations[i] = 0;
+        }
     }
 
+    // the blocks of the running threads, and what the finished ones have counted
+    struct StatsRegistry{
+        StatsRegistry() : lock(), blocks(), finished(){
+        }
+        mutex lock;
+        list<StatsBlock*> blocks;
+        StatsBlock finished;
+    };
 
-    // join
+    StatsRegistry& stats_registry(){
+        static StatsRegistry registry;
+        return registry;
+    }
 
-    template <class ComaType> struct join_with{
-        String operator()(String S1, String S2){
-            return (S1 + the_) + S2;
+    struct ThreadStats{
+        ThreadStats() : block(){
+            lock_guard<mutex> lock(stats_registry().lock);
+            stats_registry().blocks.push_back(&block);
         }
-        join_with(ComaType& the) : the_(the){
+        ~ThreadStats(){
+            lock_guard<mutex> lock(stats_registry().lock);
+            stats_merge(stats_registry().finished, block);
+            stats_registry().blocks.remove(&block);
         }
-        private: ComaType the_;
+        StatsBlock block;
     };
 
-    template <class ComaType> void do_join(String& To, const vector<String>& Lines, ComaType Coma){
-        if(Lines.empty()){
-            return;
-        }else{
-            join_with<ComaType> joiner = join_with<ComaType>(Coma);
-            To = Lines.front() + accumulate(Lines.begin()+1, Lines.end(), String(), joiner);
-            return;
-        }
+    StatsBlock& thread_stats(){
+        thread_local ThreadStats stats;
+        return stats.block;
     }
 
-    String join(const vector<String>& Lines, const Char Coma){
-        String ret;
-        do_join<Char>(ret, Lines, Coma);
-        return ret;
-    }
+    // counts a call, its time, and the text it reads and writes
+    class StatsCall{
+    public:
+        StatsCall(StatsFunction Function, size_t BytesIn) : function_(Function), start_(chrono::steady_clock::now()){
+            StatsBlock& block = thread_stats();
+            stats_add(block.calls[function_], 1);
+            stats_add(block.bytes_in[function_], BytesIn);
+        }
+        ~StatsCall(){
+            size_t nanoseconds = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start_).count();
+            stats_add(thread_stats().nanoseconds[function_], nanoseconds);
+        }
+        void out(size_t Bytes){
+            stats_add(thread_stats().bytes_out[function_], Bytes);
+        }
+        StatsCall(const StatsCall&) = delete;
+        StatsCall& operator=(const StatsCall&) = delete;
+    private:
+        StatsFunction function_;
+        chrono::steady_clock::time_point start_;
+    };
 
-    String join(const vector<String>& Lines, const String& Coma){
-        String ret;
-        do_join<String>(ret, Lines, Coma);
-        return ret;
+    // what calc has met in a single expression
+    struct CalcCounts{
+        size_t numbers = 0;
+        size_t digits = 0;
+        size_t max_digits = 0;
+        size_t operations[5] = {};
+        size_t max_depth = 0;
+    };
+
+    void stats_count(const CalcCounts& Counts, bool LongArithmetic){
+        StatsBlock& block = thread_stats();
+        stats_add(block.numbers, Counts.numbers);
+        stats_add(block.digits, Counts.digits);
+        stats_max(block.max_digits, Counts.max_digits);
+        for(size_t i = 0; i < 5; i++){
+            stats_add(block.operations[i], Counts.operations[i]);
+        }
+        stats_max(block.max_depth, Counts.max_depth);
+        stats_add(block.long_arithmetic, LongArithmetic ? 1 : 0);
     }
 
+#define LE_STATS_CALL(Function, BytesIn) StatsCall stats_call(Function, BytesIn)
+#define LE_STATS_OUT(Bytes) stats_call.out(Bytes)
+#define LE_STATS_CALC(Parser, LongArithmetic) stats_count(Parser.counts, LongArithmetic)
 
-    // replace
+#else
 
-    String replace(const String& Line, const Char Coma1, const Char Coma2){
-        return join(split(Line, Coma1), Coma2);
-    }
+#define LE_STATS_CALL(Function, BytesIn)
+#define LE_STATS_OUT(Bytes)
+#define LE_STATS_CALC(Parser, LongArithmetic)
 
-    String replace(const String& Line, const Char Coma1, const String& Coma2){
-        return join(split(Line, Coma1), Coma2);
-    }
+#endif
 
-    String replace(const String& Line, const String& Coma1, const Char Coma2){
-        return join(split(Line, Coma1), Coma2);
-    }
 
-    String replace(const String& Line, const String& Coma1, const String& Coma2){
-        return join(split(Line, Coma1), Coma2);
-    }
 
+    // char scanning: a kernel finds the first block of 16 or 32 bytes with the Char
+    // in it and gives the bit mask of all its matches, CharScan then takes them one
+    // by one. Nothing is read out of the line: the last block is the one that ends
+    // with the line, with the bits before the scanned part cleared.
 
-    // text
+    // the kernels return where the block starts, or N if there is no match from Pos on
+    typedef size_t (*ScanChar)(const Char* S, size_t N, size_t Pos, const Char C, uint32_t& Mask, size_t& Length);
 
-    template <class T>
-    String do_text(T N){
-        ostringstream ss;
-        ss << N;
-        return ss.str();
+    size_t scan_char_scalar(const Char* S, size_t N, size_t Pos, const Char C, uint32_t& Mask, size_t& Length){
+        Length = min<size_t>(N - Pos, 32);
+        Mask = 0;
+        for(size_t i = 0; i < Length; i++){
+            Mask |= uint32_t(S[Pos + i] == C) << i;
+        }
+        if(Mask != 0){
+            return Pos;
+        }
+        const Char* found = char_traits<Char>::find(S + Pos + Length, N - Pos - Length, C);
+        if(not found){
+            return N;
+        }
+        Length = 1;
+        Mask = 1;
+        return found - S;
     }
 
-    String text(const unsigned int i){
-        return do_text<unsigned int>(i);
+#ifdef LE_SSE2
+    uint32_t block_mask_sse2(const Char* S, const __m128i C){
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(S)), C));
     }
 
-    String text(const int i){
-        return do_text<int>(i);
+    size_t scan_char_sse2(const Char* S, size_t N, size_t Pos, const Char C, uint32_t& Mask, size_t& Length){
+        if(N < 16){
+            return scan_char_scalar(S, N, Pos, C, Mask, Length);
+        }
+        const __m128i c = _mm_set1_epi8(C);
+        Length = 16;
+        size_t i = Pos;
+        if(i + 16 <= N){ // the next match is usually near
+            if((Mask = block_mask_sse2(S + i, c)) != 0){
+                return i;
+            }
+            i += 16;
+        }
+        for(; i + 64 <= N; i += 64){
+            uint32_t a = block_mask_sse2(S + i, c);
+            uint32_t b = block_mask_sse2(S + i + 16, c);
+            uint32_t d = block_mask_sse2(S + i + 32, c);
+            uint32_t e = block_mask_sse2(S + i + 48, c);
+            if((a | b | d | e) != 0){
+                Mask = a ? a : b ? b : d ? d : e;
+                return i + (a ? 0 : b ? 16 : d ? 32 : 48);
+            }
+        }
+        for(; i + 16 <= N; i += 16){
+            if((Mask = block_mask_sse2(S + i, c)) != 0){
+                return i;
+            }
+        }
+        if(i < N and (Mask = block_mask_sse2(S + N - 16, c) & (~uint32_t(0) << (i + 16 - N))) != 0){
+            return N - 16;
+        }
+        return N;
     }
+#endif
 
-    String text(const unsigned short int i){
-        return do_text<unsigned short int>(i);
+#ifdef LE_AVX2
+#ifdef _MSC_VER
+#define LE_TARGET_AVX2
+#else
+#define LE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+    LE_TARGET_AVX2 uint32_t block_mask_avx2(const Char* S, const __m256i C){
+        return _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(S)), C));
     }
 
-    String text(const short int i){
-        return do_text<short int>(i);
+    LE_TARGET_AVX2 size_t scan_char_avx2(const Char* S, size_t N, size_t Pos, const Char C, uint32_t& Mask, size_t& Length){
+        if(N < 32){
+            return scan_char_sse2(S, N, Pos, C, Mask, Length);
+        }
+        const __m256i c = _mm256_set1_epi8(C);
+        Length = 32;
+        size_t i = Pos;
+        if(i + 32 <= N){ // the next match is usually near
+            if((Mask = block_mask_avx2(S + i, c)) != 0){
+                return i;
+            }
+            i += 32;
+            for(; i + 64 <= N; i += 64){
+                uint32_t a = block_mask_avx2(S + i, c);
+                uint32_t b = block_mask_avx2(S + i + 32, c);
+                if((a | b) != 0){
+                    Mask = a ? a : b;
+                    return a ? i : i + 32;
+                }
+            }
+            if(i + 32 <= N){
+                if((Mask = block_mask_avx2(S + i, c)) != 0){
+                    return i;
+                }
+                i += 32;
+            }
+        }
+        if(i < N and (Mask = block_mask_avx2(S + N - 32, c) & (~uint32_t(0) << (i + 32 - N))) != 0){
+            return N - 32;
+        }
+        return N;
     }
 
-    String text(const unsigned long int i){
-        return do_text<unsigned long int>(i);
+    bool has_avx2(){
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if(info[0] < 7){
+            return false;
+        }
+        __cpuid(info, 1);
+        const int osxsave_and_avx = (1 << 27) | (1 << 28);
+        if((info[2] & osxsave_and_avx) != osxsave_and_avx or (_xgetbv(0) & 6) != 6){
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
     }
+#endif
 
-    String text(const long int i){
-        return do_text<long int>(i);
+    ScanChar pick_scan_char(){
+        if(sizeof(Char) != 1){
+            return scan_char_scalar;
+        }
+#ifdef LE_AVX2
+        if(has_avx2()){
+            return scan_char_avx2;
+        }
+#endif
+#ifdef LE_SSE2
+        return scan_char_sse2;
+#else
+        return scan_char_scalar;
+#endif
     }
 
-    String text(const double f){
-        return do_text<double>(f);
+    size_t CharScan::scan(View Line, const Char C, size_t Pos){
+        static const ScanChar scan_char = pick_scan_char();
+        if(Pos >= Line.length()){
+            return View::npos;
+        }
+        size_t length = 0;
+        size_t block = scan_char(Line.data(), Line.length(), Pos, C, mask_, length);
+        if(block >= Line.length()){
+            begin_ = end_ = 0;
+            return View::npos;
+        }
+        begin_ = block;
+        end_ = block + length;
+        return begin_ + lowest_bit(mask_);
     }
 
-    String text(const float f){
-        return do_text<float>(f);
+    size_t find_char(View Line, const Char C, size_t Pos){
+        if(Pos >= Line.length()){
+            return View::npos;
+        }
+        const Char* found = char_traits<Char>::find(Line.data() + Pos, Line.length() - Pos, C);
+        return found ? found - Line.data() : View::npos;
     }
 
 
-    // us calc routines
+    // parallel: the range is cut in one piece per thread, a thread that is done
+    // with its piece steals the upper half of what is left of someone else's
 
-    String ensure_point(const String& S){
-        if(S.find_first_of('.') == String::npos){
-            return S+'.';
-        }else{
-            return S;
+    struct WorkPiece{
+        WorkPiece() : lock(), begin(0), end(0){
         }
-    }
+        mutex lock;
+        size_t begin;
+        size_t end;
+    };
 
-    String ensure_minus(const String& S){
-        if(S[0] != '-'){
-            return "-"+S;
-        }else{
-            return S;
+    bool take_work(WorkPiece& Piece, size_t Grain, size_t& Begin, size_t& End){
+        lock_guard<mutex> lock(Piece.lock);
+        if(Piece.begin == Piece.end){
+            return false;
         }
+        Begin = Piece.begin;
+        End = min(Piece.begin + Grain, Piece.end);
+        Piece.begin = End;
+        return true;
     }
 
-    String ensure_zero(const String& S){
-        if(S == "-0"){
-            return "0";
-        }else{
-            return S;
+    bool steal_work(deque<WorkPiece>& Pieces, size_t Thief){
+        for(size_t i = 1; i < Pieces.size(); i++){
+            WorkPiece& victim = Pieces[(Thief + i) % Pieces.size()];
+            size_t begin;
+            size_t end;
+            {
+                lock_guard<mutex> lock(victim.lock);
+                if(victim.begin == victim.end){
+                    continue;
+                }
+                begin = victim.begin + (victim.end - victim.begin) / 2;
+                end = victim.end;
+                victim.end = begin;
+            }
+            lock_guard<mutex> lock(Pieces[Thief].lock);
+            Pieces[Thief].begin = begin;
+            Pieces[Thief].end = end;
+            return true;
         }
+        return false;
     }
 
-    String invert(const String& S){
-        if(S[0] != '-'){
-            return "-"+S;
-        }else{
-            return S.substr(1, String::npos);
-        }
+    size_t parallel_threads(){
+        return max(thread::hardware_concurrency(), 1u);
     }
 
-    String align_first_to_second(const String& S1, const String& S2){
-        size_t PL1 = S1.find_first_of('.');
-        size_t PR1 = S1.length() - PL1;
-        size_t PL2 = S2.find_first_of('.');
-        size_t PR2 = S2.length() - PL2;
-        size_t PLM = max(PL1, PL2);
-        size_t PRM = max(PR1, PR2);
-        String S;
-        for(size_t i=0; i<(PLM-PL1); i++) S += '0';
-        S += S1;
-        for(size_t j=0; j<(PRM-PR1); j++) S += '0';
-        return S;
+    // calls F(Begin, End) for the [0, Count) range in pieces of at most Grain,
+    // or for all of it at once if there is only one thread for it
+    template <class Function> void parallel_for(size_t Count, size_t Grain, Function F){
+        size_t threads = min(parallel_threads(), (Count + Grain - 1) / Grain);
+        if(threads <= 1){
+            if(Count > 0){
+                F(0, Count);
+            }
+            return;
+        }
+        deque<WorkPiece> pieces(threads);
+        for(size_t i = 0; i < threads; i++){
+            pieces[i].begin = Count * i / threads;
+            pieces[i].end = Count * (i + 1) / threads;
+        }
+        exception_ptr failure;
+        mutex failure_lock;
+        auto work = [&](size_t Thread){
+            try{
+                size_t begin;
+                size_t end;
+                do{
+                    while(take_work(pieces[Thread], Grain, begin, end)){
+                        F(begin, end);
+                    }
+                }while(steal_work(pieces, Thread));
+            }catch(...){
+                lock_guard<mutex> lock(failure_lock);
+                if(not failure){
+                    failure = current_exception();
+                }
+            }
+        };
+        vector<thread> helpers;
+        helpers.reserve(threads - 1);
+        for(size_t i = 1; i < threads; i++){
+            helpers.push_back(thread(work, i));
+        }
+        work(0);
+        for(size_t i = 0; i < helpers.size(); i++){
+            helpers[i].join();
+        }
+        if(failure){
+            rethrow_exception(failure);
+        }
     }
 
-    String _align_first_to_second(const String& S1, const String& S2){
-        size_t PL1 = S1.find_first_of('.');
-        size_t PR1 = S1.length() - PL1;
-        size_t PL2 = S2.find_first_of('.');
-        size_t PR2 = S2.length() - PL2;
-        size_t PLM = max(PL1, PL2);
-        size_t PRM = max(PR1, PR2);
-        String S(PLM+PRM, '0');
-        S.replace(PLM-PL1, S1.length(), S1);
-        return S;
-    }
 
-    void align_to_each_other_with_0(const String& S1, const String& S2, String& NS1, String& NS2){
-        size_t PL1 = S1.find_first_of('.');
-        size_t PR1 = S1.length() - PL1;
-        size_t PL2 = S2.find_first_of('.');
-        size_t PR2 = S2.length() - PL2;
-        size_t PLM = max(PL1, PL2);
-        size_t PRM = max(PR1, PR2);
+    // split
 
-        NS1.assign(PLM+PRM+1, '0');
-        NS1.replace(PLM-PL1+1, S1.length(), S1);
-        NS2.assign(PLM+PRM+1, '0');
-        NS2.replace(PLM-PL2+1, S2.length(), S2);
+    size_t find_coma(View Line, const Char Coma, size_t Pos){
+        return find_char(Line, Coma, Pos);
     }
 
+    size_t find_coma(View Line, View Coma, size_t Pos){
+        if(Coma.empty()){
+            return View::npos; // an empty delimiter splits nothing
+        }
+        return Line.find(Coma, Pos);
+    }
 
-    String trim_left(const String& S){
-        String t = S.substr(S.find_first_not_of('0'), String::npos);
-        if(t == ""){
-            return "0";
+    // a rough guess of how common a byte is in text: spaces and small letters are
+    // everywhere, digits and capitals are common, markup and line breaks are less
+    // so, the rest of the punctuation and the control bytes are rare
+    int byte_commonness(const unsigned char C){
+        if(C == ' ' or (C >= 'a' and C <= 'z')){
+            return 4;
         }
-        if(t[0] == '.'){
-            return "0"+t;
+        if((C >= '0' and C <= '9') or (C >= 'A' and C <= 'Z') or C >= 0x80){
+            return 3;
         }
-        return t;
+        if(View("\r\n\t.,;:'\"<>/=-_()").find(static_cast<Char>(C)) != View::npos){
+            return 2;
+        }
+        return (C >= 0x20) ? 1 : 0;
     }
 
-    String trim_right(const String& S){
-        String t = S.substr(0, S.find_last_not_of('0') + 1);
-        if(t[t.length()-1] == '.'){
-            return t.substr(0, t.length()-1);
+    Pattern::Pattern(const String& Text) : text_(Text), rare_(0){
+        // of the equally rare bytes the last one is taken, the first one is what View::find looks for
+        for(size_t i = 1; i < text_.length(); i++){
+            if(byte_commonness(static_cast<unsigned char>(text_[i])) <= byte_commonness(static_cast<unsigned char>(text_[rare_]))){
+                rare_ = i;
+            }
         }
-        return t;
     }
 
-    String trim(const String& S){
-        String s_or_null = trim_right(trim_left(S));
-        if(s_or_null == ""){
-            return "0";
-        }else{
-            return s_or_null;
+    size_t Pattern::find(View Line, size_t Pos) const{
+        size_t len = text_.length();
+        if(len == 0){
+            return View::npos;
+        }
+        if(len == 1){
+            return find_char(Line, text_[0], Pos);
+        }
+        if(len <= pattern_short_length){
+            return Line.find(View(text_), Pos);
+        }
+        if(Pos + len > Line.length()){
+            return View::npos;
         }
+        // memchr jumps from one rare byte to another, only there the whole pattern is compared
+        const Char* first = Line.data() + Pos + rare_;
+        const Char* last = Line.data() + Line.length() - len + rare_ + 1;
+        while(first < last){
+            const Char* found = char_traits<Char>::find(first, last - first, text_[rare_]);
+            if(found == nullptr){
+                return View::npos;
+            }
+            if(char_traits<Char>::compare(found - rare_, text_.data(), len) == 0){
+                return found - rare_ - Line.data();
+            }
+            first = found + 1;
+        }
+        return View::npos;
     }
 
-    String us_add(const String& S1, const String& S2){
-        String EPS1 = ensure_point(S1);
-        String EPS2 = ensure_point(S2);
-
-        String AS1, AS2;
-        align_to_each_other_with_0(EPS1, EPS2, AS1, AS2);
+    size_t find_coma(View Line, const Pattern* Coma, size_t Pos){
+        return Coma->find(Line, Pos);
+    }
 
-        deque<Char> Res;
-        Char Add = 0;
+    CharSet::CharSet(View Chars) : in_(){
+        for(size_t i = 0; i < Chars.length(); i++){
+            in_[static_cast<unsigned char>(Chars[i])] = true;
+        }
+    }
 
-        String::reverse_iterator It1 = AS1.rbegin();
-        String::reverse_iterator It2 = AS2.rbegin();
-        String::reverse_iterator ItE1 = AS1.rend();
-        for(; It1 != ItE1; ++It1, ++It2){
-            if(*It1 == '.'){
-                Res.push_front('.');
-            }else{
-                Char n = (*It1 -'0') + (*It2 -'0') + Add;
-                if(n > 9){
-                    n -= 10;
-                    Add = 1;
-                }else{
-                    Add = 0;
-                }
-                Res.push_front(n + '0');
+    size_t find_coma(View Line, const CharSet& Coma, size_t Pos){
+        for(size_t i = Pos; i < Line.length(); i++){
+            if(Coma.contains(Line[i])){
+                return i;
             }
         }
-        return trim( String(Res.begin(), Res.end()) );
+        return View::npos;
     }
 
-    String us_sub(const String& S1, const String& S2){
-        String EPS1 = ensure_point(S1);
-        String EPS2 = ensure_point(S2);
-        String AS1, AS2, Sign;
-        align_to_each_other_with_0(EPS1, EPS2, AS1, AS2);
-        if(AS1.compare(AS2) < 0){
-            AS1.swap(AS2);
-            Sign = "-";
-        }else{
-            Sign = "";
-        }
+    // a Char delimiter is looked for with a CharScan that goes along with the search
+    size_t find_coma(View Line, const Char Coma, size_t Pos, CharScan& Scan){
+        return Scan.find(Line, Coma, Pos);
+    }
 
-        deque<Char> Res;
-        Char Sub = 0;
+    template <class ComaType> size_t find_coma(View Line, const ComaType& Coma, size_t Pos, CharScan&){
+        return find_coma(Line, Coma, Pos);
+    }
 
-        String::reverse_iterator It1 = AS1.rbegin();
-        String::reverse_iterator It2 = AS2.rbegin();
-        String::reverse_iterator ItE1 = AS1.rend();
-        for(; It1 != ItE1; ++It1, ++It2){
-            if(*It1 == '.'){
-                Res.push_front('.');
-            }else{
-                Char n = 10 + (*It1 -'0') - (*It2 -'0') - Sub;
-                if(n > 9){
-                    n -= 10;
-                    Sub = 0;
-                }else{
-                    Sub = 1;
-                }
-                Res.push_front(n + '0');
-            }
-        }
-        return Sign + trim( String(Res.begin(), Res.end()) );
+    size_t coma_length(const Char){
+        return 1;
     }
 
-    String us_mul1(const String& S, Char C){
-        Char c = C - '0';
-        String EPS = ensure_point(S);
-        String AS = "0"+EPS;
+    size_t coma_length(const CharSet&){
+        return 1;
+    }
 
-        deque<Char> Res;
-        Char Add = 0;
+    size_t coma_length(View Coma){
+        return Coma.length();
+    }
 
-        String::reverse_iterator It = AS.rbegin();
-        String::reverse_iterator ItE = AS.rend();
-        for(; It != ItE; ++It){
-            if(*It == '.'){
-                Res.push_front('.');
-            }else{
-                Char n = (*It -'0') * c + Add;
-                Add = n / 10;
-                n = n % 10;
-                Res.push_front(n + '0');
-            }
-        }
-        return trim_right(String(Res.begin(), Res.end()));
+    size_t coma_length(const Pattern* Coma){
+        return Coma->length();
     }
 
-    String mul_10(const String& N){
-        size_t point = N.find_first_of('.');
-        if(point == String::npos){
-            return N+"0";
+    template <class ComaType> void Tokens<ComaType>::iterator::find_next(){
+        size_t coma_pos = find_coma(line_, coma_, pos_);
+        if(coma_pos != View::npos){
+            token_ = line_.substr(pos_, coma_pos-pos_);
+            next_ = coma_pos + coma_length(coma_);
         }else{
-            String M=N;
-            M[point] = M[point+1];
-            M[point+1] = '.';
-            return trim_right(M);
+            token_ = line_.substr(pos_, View::npos);
+            next_ = View::npos;
         }
     }
 
-    String mul_10(const String& N, unsigned int P){
-        if(P == 0){
-            return N;
-        }else{
-            return mul_10(mul_10(N), P-1);
-        }
+    template class Tokens<Char>;
+    template class Tokens<View>;
+    template class Tokens<const Pattern*>;
+    template class Tokens<CharSet>;
+
+    Tokens<Char> split_view(View Line, const Char Coma){
+        return Tokens<Char>(Line, Coma);
     }
 
-    String div_10(const String& N){
-        size_t point = N.find_first_of('.');
-        String M;
-        if(point == String::npos){
-            M = N + N[N.length()-1];
-            M[N.length()-1] = '.';
-        }else{
-            M = N;
-            M[point] = M[point-1];
-            M[point-1] = '.';
-        }
+    Tokens<View> split_view(View Line, View Coma){
+        return Tokens<View>(Line, Coma);
+    }
 
-        if(M[0]=='.'){
-            return "0"+M;
-        }else{
-            return M;
-        }
+    Tokens<const Pattern*> split_view(View Line, const Pattern& Coma){
+        return Tokens<const Pattern*>(Line, &Coma);
     }
 
-    String div_10(const String& N, unsigned int P){
-        if(P == 0){
-            return N;
-        }else{
-            return div_10(div_10(N), P-1);
+    Tokens<CharSet> split_view(View Line, const CharSet& Comas){
+        return Tokens<CharSet>(Line, Comas);
+    }
+
+    StreamTokens::StreamTokens(istream& In, const Char Coma, size_t ChunkSize)
+        : in_(In), coma_(1, Coma), chunk_size_(max<size_t>(ChunkSize, 1)), buffer_(), pos_(0), scanned_(0), done_(false){
+    }
+
+    StreamTokens::StreamTokens(istream& In, const String& Coma, size_t ChunkSize)
+        : in_(In), coma_(Coma), chunk_size_(max<size_t>(ChunkSize, 1)), buffer_(), pos_(0), scanned_(0), done_(false){
+    }
+
+    bool StreamTokens::read_chunk(){
+        if(not in_){
+            return false;
         }
+        buffer_.erase(0, pos_); // keep only the unfinished token
+        scanned_ -= pos_;
+        pos_ = 0;
+        size_t old_size = buffer_.size();
+        buffer_.resize(old_size + chunk_size_);
+        in_.read(&buffer_[old_size], chunk_size_);
+        buffer_.resize(old_size + in_.gcount());
+        return in_.gcount() > 0;
     }
 
-    String us_mul(const String& S1, const String& S2){
-        if(S1 == "0" or S2 == "0"){
-            return "0";
+    bool StreamTokens::next(String& Token){
+        if(done_){
+            return false;
         }
-        if(S1.length() < S2.length()){
-            return us_mul(S2, S1);
-        }else{
-            size_t point = S2.find_first_of('.');
-            unsigned int shift;
-            if(point == String::npos){
-                shift = 0;
-            }else{
-                shift = S2.length() - point -1;
+        while(true){
+            size_t coma_pos = (coma_.length() == 1)
+                ? find_coma(buffer_, coma_[0], scanned_)
+                : find_coma(buffer_, View(coma_), scanned_);
+            if(coma_pos != String::npos){
+                Token.assign(buffer_, pos_, coma_pos-pos_);
+                pos_ = coma_pos + coma_.length();
+                scanned_ = pos_;
+                return true;
             }
-            String CS2 = replace(S2, '.', "");
-            String::reverse_iterator It = CS2.rbegin();
-            String::reverse_iterator ItE = CS2.rend();
-            vector<String> to_sum;
-            to_sum.reserve(CS2.length());
-            for(unsigned int i = 0; It != ItE; ++It, ++i){
-                to_sum.push_back( mul_10( us_mul1(S1, *It), i));
+            // a delimiter may straddle the chunk boundary, so its head is scanned again
+            size_t tail = coma_.empty() ? 0 : coma_.length() - 1;
+            scanned_ = max(pos_, buffer_.size() > tail ? buffer_.size() - tail : 0);
+            if(not read_chunk()){
+                Token.assign(buffer_, pos_, String::npos);
+                String().swap(buffer_);
+                done_ = true;
+                return true;
             }
-            return div_10( accumulate(to_sum.begin(), to_sum.end(), String("0"), us_add), shift);
         }
     }
 
-    bool int_less(const String& S1, const String& S2){
-        if(S1.length() < S2.length())return true;
-        if(S1.length() > S2.length())return false;
-        if(S1.compare(S2) < 0)return true;
-        return false;
+    // the Strings already in To are assigned to, the rest are added or dropped
+    template <class ComaType, class Strings> void do_split(Strings& To, View Line, ComaType Coma){
+        LE_STATS_CALL(stats_split, Line.length());
+        size_t n = 0;
+        Tokens<ComaType> tokens(Line, Coma);
+        typename Tokens<ComaType>::iterator It = tokens.begin();
+        typename Tokens<ComaType>::iterator ItE = tokens.end();
+        for(; It != ItE; ++It, ++n){
+            if(n < To.size()){
+                To[n].assign(It->begin(), It->end());
+            }else{
+                To.emplace_back(It->begin(), It->end()); // takes the allocator of To, if it has one
+            }
+            LE_STATS_OUT(It->length());
+        }
+        To.resize(n);
     }
 
-    String int_div(const String& S1, const String& S2){
-        if(int_less(S1, S2)){
-            return "0";
-        }
+    vector<String> split(const String& Line, const Char Coma){
+        vector<String> ret;
+        do_split<Char>(ret, Line, Coma);
+        return ret;
+    }
 
-        String dmuls[10];
-        dmuls[0] = "0";
-        for(unsigned int i = 1; i <= 9; i++){
-            dmuls[i] = us_mul1(S2, '0' + i);
-        }
+    vector<String> split(const String& Line, const String& Coma){
+        vector<String> ret;
+        do_split<View>(ret, Line, Coma);
+        return ret;
+    }
 
-        String n = S1;
-        String res;
-        size_t l1 = S1.length();
-        size_t l2 = S2.length();
-        for(int i = l1-l2; i >= 0; i--){
-            int j = 9;
-            String sub = "0";
-            for(; j > 0 ; j--){
-                sub = trim_left(mul_10(dmuls[j], i));
-                if(not int_less(n, sub)){
-                    break;
-                }
-            }
-            if(j>0){
-                n = us_sub(n, sub);
-            }
-            res += ('0'+j);
-        }
-        return trim_left(res);
+    vector<String> split(const String& Line, const Pattern& Coma){
+        vector<String> ret;
+        do_split<const Pattern*>(ret, Line, &Coma);
+        return ret;
     }
 
-    String us_div(const String& S1, const String& S2){
-        size_t point1 = S1.find_first_of('.');
-        unsigned int after_point1 = (point1 == String::npos)? 0 : S1.length()-point1-1;
-        size_t point2 = S2.find_first_of('.');
-        unsigned int after_point2 = (point2 == String::npos)? 0 : S2.length()-point2-1;
-        unsigned int max_after_point = max(after_point1, after_point2);
-        String IS1 = mul_10(S1, max_after_point*2);
-        String IS2 = mul_10(S2, max_after_point);
-        return div_10( int_div(IS1, IS2), max_after_point);
+    vector<String>& split_into(View Line, const Char Coma, vector<String>& To){
+        do_split<Char>(To, Line, Coma);
+        return To;
     }
 
+    vector<String>& split_into(View Line, View Coma, vector<String>& To){
+        do_split<View>(To, Line, Coma);
+        return To;
+    }
 
-    // add sub mul div
+    vector<String>& split_into(View Line, const Pattern& Coma, vector<String>& To){
+        do_split<const Pattern*>(To, Line, &Coma);
+        return To;
+    }
 
-    String add(const String& S1, const String& S2){
-        if(S1 == "" or S2 == ""){
-            throw LEExpessionSyntaxException("Add arguments problem: \"" + S1 + "\" + \"" + S2 + "\"");
+    // the first token always starts the line, so the line is cut down to it and moved,
+    // unless the token is too short to be worth keeping the whole buffer alive for
+    template <class ComaType> vector<String> do_split_moving(String& Line, ComaType Coma){
+        LE_STATS_CALL(stats_split, Line.length());
+        vector<String> ret(1);
+        Tokens<ComaType> tokens(Line, Coma);
+        typename Tokens<ComaType>::iterator It = tokens.begin();
+        typename Tokens<ComaType>::iterator ItE = tokens.end();
+        size_t first = It->length();
+        for(++It; It != ItE; ++It){
+            ret.emplace_back(It->begin(), It->end());
+            LE_STATS_OUT(It->length());
         }
-        bool SN1 = S1[0] == '-';
-        String US1 = SN1 ? S1.substr(1, String::npos) : S1;
-        bool SN2 = S2[0] == '-';
-        String US2 = SN2 ? S2.substr(1, String::npos) : S2;
-        if( !SN1 and !SN2 ){
-            return us_add(US1, US2);
-        }else if( SN1 and !SN2 ){
-            return us_sub(US2, US1);
-        }else if( !SN1 and SN2 ){
-            return us_sub(US1, US2);
+        LE_STATS_OUT(first);
+        if(first >= Line.capacity() / 2){
+            Line.resize(first);
+            ret[0].swap(Line);
         }else{
-            return ensure_minus( us_add(US1, US2) );
+            ret[0].assign(Line, 0, first);
+            String().swap(Line);
         }
+        return ret;
     }
 
-    String sub(const String& S1, const String& S2){
-        if(S1 == ""){
-            throw LEExpessionSyntaxException("Subtract arguments problem: \"" + S1 + "\" - \"" + S2 + "\"");
-        }
-        bool SN1 = S1[0] == '-';
-        String US1 = SN1 ? S1.substr(1, String::npos) : S1;
-        String RS2 = (S2=="") ? "0" : S2; // unary fix
-        bool SN2 = RS2[0] == '-';
-        String US2 = SN2 ? RS2.substr(1, String::npos) : RS2;
-        if( !SN1 and !SN2 ){
-            return us_sub(US1, US2);
-        }else if( SN1 and !SN2 ){
-            return ensure_minus( us_add(US2, US1) );
-        }else if( !SN1 and SN2 ){
-            return us_add(US1, US2);
-        }else{
-            return ensure_zero( invert( us_sub(US1, US2) ) );
-        }
+    vector<String> split(String&& Line, const Char Coma){
+        return do_split_moving<Char>(Line, Coma);
+    }
+
+    vector<String> split(String&& Line, const String& Coma){
+        return do_split_moving<View>(Line, Coma);
+    }
+
+    vector<String> split(String&& Line, const Pattern& Coma){
+        return do_split_moving<const Pattern*>(Line, &Coma);
+    }
+
+    vector<String> split_any(View Line, View Comas){
+        vector<String> ret;
+        do_split<CharSet>(ret, Line, CharSet(Comas));
+        return ret;
+    }
+
+    vector<String>& split_into(View Line, const CharSet& Comas, vector<String>& To){
+        do_split<CharSet>(To, Line, Comas);
+        return To;
+    }
+
+
+    // csv
+
+    // an unquoted field ends at the delimiter or a line break
+    CharSet csv_stops(const Char Coma){
+        const Char stops[3] = {Coma, '\r', '\n'};
+        return CharSet(View(stops, 3));
+    }
+
+    CsvFields::CsvFields(View Text, const Char Coma)
+        : text_(Text), coma_(Coma), stops_(csv_stops(Coma)), pos_(0), end_of_record_(false), done_(Text.empty()), unquoted_(){
     }
 
-    String mul(const String& S1, const String& S2){
-        if(S1 == "" or S2 == ""){
-            throw LEExpessionSyntaxException("Multiply arguments problem: \"" + S1 + "\" * \"" + S2 + "\"");
+    bool CsvFields::next(View& Field){
+        if(done_){
+            return false;
+        }
+        if(pos_ == text_.length()){ // the text ends with a delimiter, so the last field is empty
+            Field = text_.substr(pos_);
+            end_of_record_ = true;
+            done_ = true;
+            return true;
         }
-        if(S1 == "0" or S2 == "0"){
-            return "0";
+        end_of_record_ = false;
+        if(text_[pos_] == '"'){
+            // the quoted part is only copied if there are doubled quotes in it
+            size_t from = pos_ + 1;
+            bool copied = false;
+            unquoted_.clear();
+            while(true){
+                size_t quote = find_char(text_, '"', from);
+                if(quote == View::npos){ // not closed, takes the rest of the text
+                    Field = text_.substr(from);
+                    pos_ = text_.length();
+                    break;
+                }
+                if(quote + 1 < text_.length() and text_[quote+1] == '"'){
+                    unquoted_.append(text_, from, quote+1-from);
+                    from = quote + 2;
+                    copied = true;
+                    continue;
+                }
+                Field = text_.substr(from, quote-from);
+                pos_ = quote + 1;
+                break;
+            }
+            // whatever is between the closing quote and the delimiter is kept as it is
+            size_t end = min(find_coma(text_, stops_, pos_), text_.length());
+            if(copied or end != pos_){
+                unquoted_.append(Field);
+                unquoted_.append(text_, pos_, end-pos_);
+                Field = unquoted_;
+            }
+            pos_ = end;
+        }else{
+            size_t end = min(find_coma(text_, stops_, pos_), text_.length());
+            Field = text_.substr(pos_, end-pos_);
+            pos_ = end;
         }
-        bool SN1 = S1[0] == '-';
-        String US1 = SN1 ? S1.substr(1, String::npos) : S1;
-        bool SN2 = S2[0] == '-';
-        String US2 = SN2 ? S2.substr(1, String::npos) : S2;
-        if( (!SN1 and !SN2) or (SN1 and SN2) ){
-            return us_mul(US1, US2);
+        if(pos_ == text_.length()){
+            end_of_record_ = true;
+            done_ = true;
+        }else if(text_[pos_] == coma_){
+            pos_++;
         }else{
-            return ensure_minus( us_mul(US1, US2) );
+            if(text_[pos_] == '\r' and pos_ + 1 < text_.length() and text_[pos_+1] == '\n'){
+                pos_++;
+            }
+            pos_++;
+            end_of_record_ = true;
+            done_ = (pos_ == text_.length()); // the last line break starts no record
+        }
+        return true;
+    }
+
+    vector<String>& split_csv_into(View Record, const Char Coma, vector<String>& To){
+        LE_STATS_CALL(stats_split, Record.length());
+        size_t n = 0;
+        CsvFields fields(Record, Coma);
+        View field;
+        while(fields.next(field)){
+            if(n < To.size()){
+                To[n].assign(field.begin(), field.end());
+            }else{
+                To.emplace_back(field.begin(), field.end());
+            }
+            n++;
+            LE_STATS_OUT(field.length());
+            if(fields.end_of_record()){
+                break;
+            }
         }
+        To.resize(n);
+        return To;
+    }
+
+    vector<String> split_csv(View Record, const Char Coma){
+        vector<String> ret;
+        split_csv_into(Record, Coma, ret);
+        return ret;
     }
 
-    String div(const String& S1, const String& S2){
-        if(S1 == "" or S2 == ""){
-            throw LEExpessionSyntaxException("Divide arguments problem: \"" + S1 + "\" / \"" + S2 + "\"");
+
+    // join
+
+    // what join reads, for stats
+    template <class It> size_t lines_length(It Begin, const It End){
+        size_t ret = 0;
+        for(; Begin != End; ++Begin){
+            ret += Begin->length();
         }
-        if(S1 == "0"){
-            return "0";
+        return ret;
+    }
+
+    String join(const vector<String>& Lines, const Char Coma){
+        LE_STATS_CALL(stats_join, lines_length(Lines.begin(), Lines.end()));
+        String ret;
+        join_into(ret, Lines.begin(), Lines.end(), Coma);
+        LE_STATS_OUT(ret.length());
+        return ret;
+    }
+
+    String join(const vector<String>& Lines, const String& Coma){
+        LE_STATS_CALL(stats_join, lines_length(Lines.begin(), Lines.end()));
+        String ret;
+        join_into(ret, Lines.begin(), Lines.end(), View(Coma));
+        LE_STATS_OUT(ret.length());
+        return ret;
+    }
+
+    // the rest is appended to the first line
+    String do_join_moving(vector<String>& Lines, View Coma){
+        LE_STATS_CALL(stats_join, lines_length(Lines.begin(), Lines.end()));
+        String ret;
+        if(Lines.empty()){
+            return ret;
         }
-        if(S2 == "0"){
-            throw LEDivByZeroException("Problem calculating: \"" + S1 + "\" / \"" + S2 + "\"");
+        ret.swap(Lines[0]);
+        size_t length = ret.length();
+        for(size_t i = 1; i < Lines.size(); i++){
+            length += Coma.length() + Lines[i].length();
         }
-        bool SN1 = S1[0] == '-';
-        String US1 = SN1 ? S1.substr(1, String::npos) : S1;
-        bool SN2 = S2[0] == '-';
-        String US2 = SN2 ? S2.substr(1, String::npos) : S2;
-        if( (!SN1 and !SN2) or (SN1 and SN2) ){
-            return us_div(US1, US2);
-        }else{
-            return ensure_zero( ensure_minus( us_div(US1, US2) ) );
+        ret.reserve(length);
+        for(size_t i = 1; i < Lines.size(); i++){
+            ret.append(Coma);
+            ret.append(Lines[i]);
         }
+        LE_STATS_OUT(ret.length());
+        return ret;
     }
 
+    String join(vector<String>&& Lines, const Char Coma){
+        return do_join_moving(Lines, View(&Coma, 1));
+    }
 
-    // calc
-	size_t find_matching_bracket(String str, size_t start){
-	    String::iterator strIt = str.begin() + start;
-    	String::iterator strItE = str.end();
-		int depth = 0;
-		int pos = start;
-		for( ; strIt != strItE; ++strIt, pos++){
-			if( (*strIt) == '(' ){
-				depth++;
-			}
-			if( (*strIt) == ')' ){
-				depth--;
-				if( depth == 0 ){
-					return pos;
-				}
-			}
-		}
-		return String::npos;
-	}
+    String join(vector<String>&& Lines, const String& Coma){
+        return do_join_moving(Lines, Coma);
+    }
 
 
+    // replace
+
+    template <class ComaType> size_t count_comas(View Line, ComaType Coma){
+        size_t n = 0;
+        size_t len = coma_length(Coma);
+        CharScan scan;
+        for(size_t pos = find_coma(Line, Coma, 0, scan); pos != View::npos; pos = find_coma(Line, Coma, pos+len, scan)){
+            n++;
+        }
+        return n;
+    }
+
+    template <class ComaType, class Out> void do_replace(Out& To, View Line, ComaType Coma1, View Coma2){
+        LE_STATS_CALL(stats_replace, Line.length());
+        size_t len1 = coma_length(Coma1);
+        CharScan scan;
+        size_t pos = find_coma(Line, Coma1, 0, scan);
+        if(pos == View::npos){
+            To.assign(Line);
+            LE_STATS_OUT(To.length());
+            return;
+        }
+        if(Coma2.length() > len1){
+            To.reserve(Line.length() + count_comas(Line, Coma1) * (Coma2.length() - len1));
+        }else{
+            To.reserve(Line.length());
+        }
+        size_t last = 0;
+        for(; pos != View::npos; pos = find_coma(Line, Coma1, last, scan)){
+            To.append(Line, last, pos-last);
+            To.append(Coma2);
+            last = pos+len1;
+        }
+        To.append(Line, last, View::npos);
+        LE_STATS_OUT(To.length());
+    }
+
+    String replace(const String& Line, const Char Coma1, const Char Coma2){
+        String ret = Line;
+        replace_inplace(ret, Coma1, Coma2);
+        return ret;
+    }
+
+    String replace(const String& Line, const Char Coma1, const String& Coma2){
+        String ret;
+        do_replace<Char>(ret, Line, Coma1, Coma2);
+        return ret;
+    }
+
+    String replace(const String& Line, const String& Coma1, const Char Coma2){
+        String ret;
+        do_replace<View>(ret, Line, Coma1, View(&Coma2, 1));
+        return ret;
+    }
+
+    String replace(const String& Line, const String& Coma1, const String& Coma2){
+        String ret;
+        do_replace<View>(ret, Line, Coma1, Coma2);
+        return ret;
+    }
+
+    String replace(const String& Line, const Pattern& Coma1, const Char Coma2){
+        String ret;
+        do_replace<const Pattern*>(ret, Line, &Coma1, View(&Coma2, 1));
+        return ret;
+    }
+
+    String replace(const String& Line, const Pattern& Coma1, const String& Coma2){
+        String ret;
+        do_replace<const Pattern*>(ret, Line, &Coma1, Coma2);
+        return ret;
+    }
+
+    void replace_inplace(String& Line, const Char Coma1, const Char Coma2){
+        LE_STATS_CALL(stats_replace, Line.length());
+        LE_STATS_OUT(Line.length());
+        CharScan scan;
+        for(size_t pos = scan.find(Line, Coma1, 0); pos != String::npos; pos = scan.find(Line, Coma1, pos+1)){
+            Line[pos] = Coma2;
+        }
+    }
+
+    template <class ComaType> void do_replace_inplace(String& Line, ComaType Coma1, View Coma2){
+        size_t len1 = coma_length(Coma1);
+        size_t len2 = Coma2.length();
+        if(len2 > len1){
+            String ret;
+            do_replace<ComaType>(ret, Line, Coma1, Coma2);
+            Line.swap(ret);
+            return;
+        }
+        LE_STATS_CALL(stats_replace, Line.length());
+        // the text is compacted from left to right, so the part still to be searched is never touched
+        size_t from = 0;
+        size_t to = 0;
+        CharScan scan;
+        for(size_t pos = find_coma(Line, Coma1, 0, scan); pos != String::npos; pos = find_coma(Line, Coma1, from, scan)){
+            if(to != from){
+                char_traits<Char>::move(&Line[to], &Line[from], pos-from);
+            }
+            to += pos-from;
+            char_traits<Char>::copy(&Line[to], Coma2.data(), len2);
+            to += len2;
+            from = pos+len1;
+        }
+        if(to != from){
+            char_traits<Char>::move(&Line[to], &Line[from], Line.length()-from);
+            Line.resize(to + Line.length()-from);
+        }
+        LE_STATS_OUT(Line.length());
+    }
+
+    void replace_inplace(String& Line, const Char Coma1, const String& Coma2){
+        do_replace_inplace<Char>(Line, Coma1, Coma2);
+    }
+
+    void replace_inplace(String& Line, const String& Coma1, const Char Coma2){
+        do_replace_inplace<View>(Line, Coma1, View(&Coma2, 1));
+    }
+
+    void replace_inplace(String& Line, const String& Coma1, const String& Coma2){
+        do_replace_inplace<View>(Line, Coma1, Coma2);
+    }
+
+    void replace_inplace(String& Line, const Pattern& Coma1, const Char Coma2){
+        do_replace_inplace<const Pattern*>(Line, &Coma1, View(&Coma2, 1));
+    }
+
+    void replace_inplace(String& Line, const Pattern& Coma1, const String& Coma2){
+        do_replace_inplace<const Pattern*>(Line, &Coma1, Coma2);
+    }
+
+    String replace(String&& Line, const Char Coma1, const Char Coma2){
+        replace_inplace(Line, Coma1, Coma2);
+        return std::move(Line);
+    }
+
+    String replace(String&& Line, const Char Coma1, const String& Coma2){
+        replace_inplace(Line, Coma1, Coma2);
+        return std::move(Line);
+    }
+
+    String replace(String&& Line, const String& Coma1, const Char Coma2){
+        replace_inplace(Line, Coma1, Coma2);
+        return std::move(Line);
+    }
+
+    String replace(String&& Line, const String& Coma1, const String& Coma2){
+        replace_inplace(Line, Coma1, Coma2);
+        return std::move(Line);
+    }
+
+    String replace(String&& Line, const Pattern& Coma1, const Char Coma2){
+        replace_inplace(Line, Coma1, Coma2);
+        return std::move(Line);
+    }
+
+    String replace(String&& Line, const Pattern& Coma1, const String& Coma2){
+        replace_inplace(Line, Coma1, Coma2);
+        return std::move(Line);
+    }
+
+
+
+    // parallel split and replace: every piece of the line is searched for delimiters
+    // on its own, then the pieces are put in line, then the tokens or the replaced
+    // text are copied out, again a piece per thread
+
+    const size_t parallel_piece_length = 256*1024;
+
+    struct LinePieces{
+        LinePieces() : bounds(), comas(){
+        }
+        vector<size_t> bounds;         // the pieces are [bounds[i], bounds[i+1])
+        vector<vector<size_t>> comas;  // where the delimiters that start in a piece are
+    };
+
+    // a delimiter that starts in the piece may end in the next one
+    template <class ComaType> void find_comas(View Line, ComaType Coma, size_t From, size_t To, vector<size_t>& Comas){
+        size_t len = coma_length(Coma);
+        View piece = Line.substr(0, To + len - 1);
+        CharScan scan;
+        for(size_t pos = find_coma(piece, Coma, From, scan); pos != View::npos and pos < To; pos = find_coma(piece, Coma, pos+len, scan)){
+            Comas.push_back(pos);
+        }
+    }
+
+    template <class ComaType> void cut_in_pieces(View Line, ComaType Coma, LinePieces& To){
+        size_t pieces = min(Line.length() / parallel_piece_length, parallel_threads() * 16);
+        To.bounds.resize(pieces + 1);
+        for(size_t i = 0; i <= pieces; i++){
+            To.bounds[i] = Line.length() * i / pieces;
+        }
+        To.comas.resize(pieces);
+        parallel_for(pieces, 1, [&](size_t Begin, size_t End){
+            for(size_t i = Begin; i < End; i++){
+                find_comas(Line, Coma, To.bounds[i], To.bounds[i+1], To.comas[i]);
+            }
+        });
+        // a delimiter that crosses into the next piece hides the ones it overlaps
+        // there, so the piece is searched again after it until the search meets
+        // a delimiter found before, since from then on it goes the same way
+        size_t len = coma_length(Coma);
+        size_t reach = 0;
+        for(size_t i = 0; i < pieces; i++){
+            vector<size_t>& comas = To.comas[i];
+            if(not comas.empty() and comas.front() < reach){
+                vector<size_t> found;
+                find_comas(Line, Coma, reach, To.bounds[i+1], found);
+                vector<size_t>::iterator same = comas.end();
+                for(size_t j = 0; j < found.size(); j++){
+                    same = lower_bound(comas.begin(), comas.end(), found[j]);
+                    if(same != comas.end() and *same == found[j]){
+                        found.resize(j);
+                        break;
+                    }
+                    same = comas.end();
+                }
+                found.insert(found.end(), same, comas.end());
+                comas.swap(found);
+            }
+            if(not comas.empty()){
+                reach = comas.back() + len;
+            }
+        }
+    }
+
+    template <class ComaType> vector<String> do_parallel_split(const String& Line, ComaType Coma){
+        LE_STATS_CALL(stats_split, Line.length());
+        LE_STATS_OUT(Line.length());
+        LinePieces pieces;
+        cut_in_pieces(Line, Coma, pieces);
+        size_t len = coma_length(Coma);
+        // the first token of a piece and where it starts
+        vector<size_t> first(pieces.comas.size() + 1, 0);
+        vector<size_t> start(pieces.comas.size() + 1, 0);
+        for(size_t i = 0; i < pieces.comas.size(); i++){
+            first[i+1] = first[i] + pieces.comas[i].size();
+            start[i+1] = pieces.comas[i].empty() ? start[i] : pieces.comas[i].back() + len;
+        }
+        vector<String> ret(first.back() + 1);
+        parallel_for(pieces.comas.size(), 1, [&](size_t Begin, size_t End){
+            for(size_t i = Begin; i < End; i++){
+                size_t last = start[i];
+                for(size_t j = 0; j < pieces.comas[i].size(); j++){
+                    ret[first[i] + j].assign(Line, last, pieces.comas[i][j] - last);
+                    last = pieces.comas[i][j] + len;
+                }
+            }
+        });
+        ret.back().assign(Line, start.back(), String::npos);
+        return ret;
+    }
+
+    template <class ComaType> String do_parallel_replace(const String& Line, ComaType Coma1, View Coma2){
+        LE_STATS_CALL(stats_replace, Line.length());
+        LinePieces pieces;
+        cut_in_pieces(Line, Coma1, pieces);
+        size_t len1 = coma_length(Coma1);
+        // a piece copies from where the last delimiter before it ends, if that is past
+        // its start, and the delimiters before it tell where that goes in the result
+        vector<size_t> from(pieces.bounds);
+        vector<size_t> to(pieces.bounds.size(), 0);
+        size_t comas = 0;
+        for(size_t i = 0; i < pieces.comas.size(); i++){
+            comas += pieces.comas[i].size();
+            if(not pieces.comas[i].empty()){
+                from[i+1] = max(from[i+1], pieces.comas[i].back() + len1);
+            }
+            to[i+1] = from[i+1] - comas * len1 + comas * Coma2.length();
+        }
+        String ret;
+        ret.resize(to.back());
+        parallel_for(pieces.comas.size(), 1, [&](size_t Begin, size_t End){
+            for(size_t i = Begin; i < End; i++){
+                size_t last = from[i];
+                Char* out = &ret[0] + to[i];
+                for(size_t j = 0; j < pieces.comas[i].size(); j++){
+                    out = char_traits<Char>::copy(out, Line.data() + last, pieces.comas[i][j] - last) + (pieces.comas[i][j] - last);
+                    out = char_traits<Char>::copy(out, Coma2.data(), Coma2.length()) + Coma2.length();
+                    last = pieces.comas[i][j] + len1;
+                }
+                char_traits<Char>::copy(out, Line.data() + last, from[i+1] - last);
+            }
+        });
+        LE_STATS_OUT(ret.length());
+        return ret;
+    }
+
+    // a line too short, a single thread, or an empty delimiter gets nothing from the threads
+    template <class ComaType> bool go_parallel(View Line, ComaType Coma){
+        return Line.length() >= parallel_min_length and parallel_threads() > 1 and coma_length(Coma) > 0;
+    }
+
+    vector<String> parallel_split(const String& Line, const Char Coma){
+        return go_parallel(Line, Coma) ? do_parallel_split<Char>(Line, Coma) : split(Line, Coma);
+    }
+
+    vector<String> parallel_split(const String& Line, const String& Coma){
+        return go_parallel(Line, View(Coma)) ? do_parallel_split<View>(Line, Coma) : split(Line, Coma);
+    }
+
+    vector<String> parallel_split(const String& Line, const Pattern& Coma){
+        return go_parallel(Line, &Coma) ? do_parallel_split<const Pattern*>(Line, &Coma) : split(Line, Coma);
+    }
+
+    String parallel_replace(const String& Line, const Char Coma1, const Char Coma2){
+        if(not go_parallel(Line, Coma1)){
+            return replace(Line, Coma1, Coma2);
+        }
+        LE_STATS_CALL(stats_replace, Line.length());
+        LE_STATS_OUT(Line.length());
+        String ret;
+        ret.resize(Line.length());
+        size_t pieces = min(Line.length() / parallel_piece_length, parallel_threads() * 16);
+        parallel_for(pieces, 1, [&](size_t Begin, size_t End){
+            for(size_t i = Begin; i < End; i++){
+                size_t from = Line.length() * i / pieces;
+                size_t to = Line.length() * (i+1) / pieces;
+                char_traits<Char>::copy(&ret[from], Line.data() + from, to - from);
+                View piece(ret.data(), to);
+                CharScan scan;
+                for(size_t pos = scan.find(piece, Coma1, from); pos != View::npos; pos = scan.find(piece, Coma1, pos+1)){
+                    ret[pos] = Coma2;
+                }
+            }
+        });
+        return ret;
+    }
+
+    String parallel_replace(const String& Line, const Char Coma1, const String& Coma2){
+        return go_parallel(Line, Coma1) ? do_parallel_replace<Char>(Line, Coma1, Coma2) : replace(Line, Coma1, Coma2);
+    }
+
+    String parallel_replace(const String& Line, const String& Coma1, const Char Coma2){
+        return go_parallel(Line, View(Coma1)) ? do_parallel_replace<View>(Line, Coma1, View(&Coma2, 1)) : replace(Line, Coma1, Coma2);
+    }
+
+    String parallel_replace(const String& Line, const String& Coma1, const String& Coma2){
+        return go_parallel(Line, View(Coma1)) ? do_parallel_replace<View>(Line, Coma1, Coma2) : replace(Line, Coma1, Coma2);
+    }
+
+    String parallel_replace(const String& Line, const Pattern& Coma1, const Char Coma2){
+        return go_parallel(Line, &Coma1) ? do_parallel_replace<const Pattern*>(Line, &Coma1, View(&Coma2, 1)) : replace(Line, Coma1, Coma2);
+    }
+
+    String parallel_replace(const String& Line, const Pattern& Coma1, const String& Coma2){
+        return go_parallel(Line, &Coma1) ? do_parallel_replace<const Pattern*>(Line, &Coma1, Coma2) : replace(Line, Coma1, Coma2);
+    }
+
+
+    // replace_all
+
+    const size_t alphabet = UCHAR_MAX + 1;
+
+    int Replacer::add_state(size_t Depth){
+        next_.resize(next_.size() + alphabet, -1);
+        depth_.push_back(Depth);
+        found_.push_back(-1);
+        return depth_.size() - 1;
+    }
+
+    Replacer::Replacer(const Replacements& Rs) : next_(), depth_(), found_(), replacements_(Rs){
+        add_state(0);
+        for(size_t i = 0; i < replacements_.size(); i++){
+            const String& from = replacements_[i].first;
+            if(from.empty()){
+                continue;
+            }
+            int state = 0;
+            for(size_t j = 0; j < from.length(); j++){
+                size_t c = static_cast<unsigned char>(from[j]);
+                if(next_[state*alphabet + c] < 0){
+                    int new_state = add_state(j+1);
+                    next_[state*alphabet + c] = new_state;
+                }
+                state = next_[state*alphabet + c];
+            }
+            if(found_[state] < 0){
+                found_[state] = i; // the first of the duplicates wins
+            }
+        }
+
+        // breadth first: failure transitions go to shallower states, which are already complete
+        vector<int> fail(depth_.size(), 0);
+        deque<int> queue;
+        for(size_t c = 0; c < alphabet; c++){
+            if(next_[c] < 0){
+                next_[c] = 0;
+            }else{
+                queue.push_back(next_[c]);
+            }
+        }
+        while(not queue.empty()){
+            int state = queue.front();
+            queue.pop_front();
+            if(found_[state] < 0){
+                found_[state] = found_[fail[state]]; // the longest match ending here
+            }
+            for(size_t c = 0; c < alphabet; c++){
+                int child = next_[state*alphabet + c];
+                int fallback = next_[fail[state]*alphabet + c];
+                if(child < 0){
+                    next_[state*alphabet + c] = fallback;
+                }else{
+                    fail[child] = fallback;
+                    queue.push_back(child);
+                }
+            }
+        }
+    }
+
+    String& Replacer::replace_into(String& To, View Line) const{
+        LE_STATS_CALL(stats_replace_all, Line.length());
+        LE_STATS_OUT(0 - To.length()); // what was there before doesn't count
+        To.reserve(To.length() + Line.length());
+        size_t last = 0;
+        size_t i = 0;
+        int state = 0;
+        size_t best_start = View::npos;
+        size_t best_length = 0;
+        int best = -1;
+        while(true){
+            if(i < Line.length()){
+                state = next_[state*alphabet + static_cast<unsigned char>(Line[i])];
+                i++;
+                if(found_[state] >= 0){
+                    size_t length = replacements_[found_[state]].first.length();
+                    size_t start = i - length;
+                    if(best < 0 or start < best_start or (start == best_start and length > best_length)){
+                        best_start = start;
+                        best_length = length;
+                        best = found_[state];
+                    }
+                }
+                // any match still to come starts at i - depth or later
+                if(best < 0 or best_start >= i - depth_[state]){
+                    continue;
+                }
+            }else if(best < 0){
+                break;
+            }
+            To.append(Line, last, best_start-last);
+            To.append(replacements_[best].second);
+            last = best_start + best_length;
+            i = last;
+            state = 0;
+            best = -1;
+        }
+        To.append(Line, last, View::npos);
+        LE_STATS_OUT(To.length());
+        return To;
+    }
+
+    String Replacer::operator()(View Line) const{
+        String ret;
+        replace_into(ret, Line);
+        return ret;
+    }
+
+    String replace_all(const String& Line, const Replacements& Rs){
+        return Replacer(Rs)(Line);
+    }
+
+
+    // text
+
+    template <class T> char* text_into(char* Buf, const T N){
+        return to_chars(Buf, Buf + text_max_length, N).ptr;
+    }
+
+    template <class T> String& text_into(String& To, const T N){
+        char buf[text_max_length];
+        return To.append(buf, text_into(buf, N));
+    }
+
+    // for the numbers le writes for itself, which stats should not count as text calls
+    template <class T> String plain_text(const T N){
+        String ret;
+        return text_into(ret, N);
+    }
+
+    template <class T> String& text_into(String& To, const vector<T>& Ns, const Char Coma){
+        LE_STATS_CALL(stats_text, 0);
+        LE_STATS_OUT(0 - To.length());
+        size_t end = To.length();
+        for(size_t i = 0; i < Ns.size(); i++){
+            To.resize(end + text_max_length + 1); // grows geometrically, like push_back
+            if(i != 0){
+                To[end++] = Coma;
+            }
+            end = text_into(&To[end], Ns[i]) - To.data();
+        }
+        To.resize(end);
+        LE_STATS_OUT(end);
+        return To;
+    }
+
+    template <class T> String text(const vector<T>& Ns, const Char Coma){
+        String ret;
+        text_into(ret, Ns, Coma);
+        return ret;
+    }
+
+    template <class T>
+    String do_text(T N){
+        LE_STATS_CALL(stats_text, 0);
+        char buf[text_max_length];
+        char* end = text_into(buf, N);
+        LE_STATS_OUT(end - buf);
+        return String(buf, end);
+    }
+
+#define LE_TEXT_FOR(T) \
+    template char* text_into<T>(char*, const T); \
+    template String& text_into<T>(String&, const T); \
+    template String& text_into<T>(String&, const vector<T>&, const Char); \
+    template String text<T>(const vector<T>&, const Char);
+
+    LE_TEXT_FOR(short int)
+    LE_TEXT_FOR(int)
+    LE_TEXT_FOR(long int)
+    LE_TEXT_FOR(unsigned short int)
+    LE_TEXT_FOR(unsigned int)
+    LE_TEXT_FOR(unsigned long int)
+    LE_TEXT_FOR(float)
+    LE_TEXT_FOR(double)
+
+#undef LE_TEXT_FOR
+
+    String text(const unsigned int i){
+        return do_text<unsigned int>(i);
+    }
+
+    String text(const int i){
+        return do_text<int>(i);
+    }
+
+    String text(const unsigned short int i){
+        return do_text<unsigned short int>(i);
+    }
+
+    String text(const short int i){
+        return do_text<short int>(i);
+    }
+
+    String text(const unsigned long int i){
+        return do_text<unsigned long int>(i);
+    }
+
+    String text(const long int i){
+        return do_text<long int>(i);
+    }
+
+    String text(const double f){
+        return do_text<double>(f);
+    }
+
+    String text(const float f){
+        return do_text<float>(f);
+    }
+
+
+    // decimal arithmetics: a number is an integer of base 10^9 limbs, the least
+    // significant first, and the count of its decimal digits after the point.
+    // A product keeps all the digits after the point for a division that may
+    // follow, but drops its trailing zeros when it is written out.
+
+    typedef uint32_t Limb;
+    typedef vector<Limb> Limbs;
+    const Limb limb_base = 1000000000;
+    const unsigned int limb_digits = 9;
+    const Limb powers_of_10[limb_digits+1] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+    struct Decimal{
+        Decimal() : limbs(), scale(0), negative(false), product(false){
+        }
+        Limbs limbs;
+        unsigned int scale;
+        bool negative;
+        bool product;
+    };
+
+    void limbs_normalize(Limbs& A){
+        while(not A.empty() and A.back() == 0){
+            A.pop_back();
+        }
+    }
+
+    int limbs_compare(const Limbs& A, const Limbs& B){
+        if(A.size() != B.size()){
+            return (A.size() < B.size()) ? -1 : 1;
+        }
+        for(size_t i = A.size(); i-- > 0; ){
+            if(A[i] != B[i]){
+                return (A[i] < B[i]) ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    void limbs_add(Limbs& A, const Limbs& B){
+        if(A.size() < B.size()){
+            A.resize(B.size(), 0);
+        }
+        Limb carry = 0;
+        for(size_t i = 0; i < A.size(); i++){
+            Limb sum = A[i] + carry + ((i < B.size()) ? B[i] : 0);
+            carry = (sum >= limb_base) ? 1 : 0;
+            A[i] = sum - carry * limb_base;
+            if(carry == 0 and i >= B.size()){
+                break;
+            }
+        }
+        if(carry != 0){
+            A.push_back(carry);
+        }
+    }
+
+    void limbs_sub(Limbs& A, const Limbs& B){ // A >= B
+        Limb borrow = 0;
+        for(size_t i = 0; i < A.size(); i++){
+            Limb subtrahend = borrow + ((i < B.size()) ? B[i] : 0);
+            if(A[i] >= subtrahend){
+                A[i] -= subtrahend;
+                borrow = 0;
+            }else{
+                A[i] += limb_base - subtrahend;
+                borrow = 1;
+            }
+            if(borrow == 0 and i >= B.size()){
+                break;
+            }
+        }
+        limbs_normalize(A);
+    }
+
+    void limbs_mul_small(Limbs& A, Limb M){
+        uint64_t carry = 0;
+        for(size_t i = 0; i < A.size(); i++){
+            uint64_t product = uint64_t(A[i]) * M + carry;
+            A[i] = product % limb_base;
+            carry = product / limb_base;
+        }
+        if(carry != 0){
+            A.push_back(carry);
+        }
+        limbs_normalize(A);
+    }
+
+    Limb limbs_div_small(Limbs& A, Limb D){
+        uint64_t rest = 0;
+        for(size_t i = A.size(); i-- > 0; ){
+            uint64_t part = rest * limb_base + A[i];
+            A[i] = part / D;
+            rest = part % D;
+        }
+        limbs_normalize(A);
+        return rest;
+    }
+
+    Limbs limbs_schoolbook_mul(const Limbs& A, const Limbs& B){
+        if(A.empty() or B.empty()){
+            return Limbs();
+        }
+        // the partial sums are kept in 64 bits and carried every 16 rows
+        vector<uint64_t> sums(A.size() + B.size(), 0);
+        for(size_t i = 0; i < A.size(); i++){
+            for(size_t j = 0; j < B.size(); j++){
+                sums[i+j] += uint64_t(A[i]) * B[j];
+            }
+            if(i % 16 == 15 or i + 1 == A.size()){
+                uint64_t carry = 0;
+                for(size_t k = 0; k < sums.size(); k++){
+                    sums[k] += carry;
+                    carry = sums[k] / limb_base;
+                    sums[k] %= limb_base;
+                }
+            }
+        }
+        Limbs ret(sums.begin(), sums.end());
+        limbs_normalize(ret);
+        return ret;
+    }
+
+    // multiplication and division thresholds, in limbs
+
+    const size_t newton_exact_limbs = 16;
+
+    atomic<size_t> karatsuba_limbs(default_karatsuba_digits / limb_digits);
+    atomic<size_t> ntt_limbs(default_ntt_digits / limb_digits);
+    atomic<size_t> newton_limbs(default_newton_digits / limb_digits);
+
+    CalcTuning calc_tuning(){
+        CalcTuning ret;
+        ret.karatsuba_digits = karatsuba_limbs * limb_digits;
+        ret.ntt_digits = ntt_limbs * limb_digits;
+        ret.newton_digits = newton_limbs * limb_digits;
+        return ret;
+    }
+
+    void calc_tuning(const CalcTuning& Tuning){
+        karatsuba_limbs = max<size_t>(Tuning.karatsuba_digits / limb_digits, 2);
+        ntt_limbs = max<size_t>(Tuning.ntt_digits / limb_digits, 2);
+        newton_limbs = max<size_t>(Tuning.newton_digits / limb_digits, newton_exact_limbs);
+    }
+
+    Limbs limbs_mul(const Limbs& A, const Limbs& B);
+
+    void limbs_add_shifted(Limbs& To, const Limbs& A, size_t Shift){
+        if(A.empty()){
+            return;
+        }
+        if(To.size() < A.size() + Shift){
+            To.resize(A.size() + Shift, 0);
+        }
+        Limb carry = 0;
+        size_t i = 0;
+        for(; i < A.size() or carry != 0; i++){
+            if(i + Shift == To.size()){
+                To.push_back(0);
+            }
+            Limb sum = To[i+Shift] + carry + ((i < A.size()) ? A[i] : 0);
+            carry = (sum >= limb_base) ? 1 : 0;
+            To[i+Shift] = sum - carry * limb_base;
+        }
+    }
+
+    Limbs limbs_part(const Limbs& A, size_t From, size_t To){
+        From = min(From, A.size());
+        To = min(To, A.size());
+        Limbs ret(A.begin() + From, A.begin() + To);
+        limbs_normalize(ret);
+        return ret;
+    }
+
+    // (a1 B^m + a0)(b1 B^m + b0) = z2 B^2m + ((a1 + a0)(b1 + b0) - z2 - z0) B^m + z0
+    Limbs limbs_karatsuba_mul(const Limbs& A, const Limbs& B){
+        size_t m = max(A.size(), B.size()) / 2;
+        Limbs a0 = limbs_part(A, 0, m);
+        Limbs a1 = limbs_part(A, m, A.size());
+        Limbs b0 = limbs_part(B, 0, m);
+        Limbs b1 = limbs_part(B, m, B.size());
+        Limbs z0 = limbs_mul(a0, b0);
+        Limbs z2 = limbs_mul(a1, b1);
+        limbs_add(a0, a1);
+        limbs_add(b0, b1);
+        Limbs z1 = limbs_mul(a0, b0);
+        limbs_sub(z1, z0);
+        limbs_sub(z1, z2);
+        Limbs ret = z0;
+        limbs_add_shifted(ret, z1, m);
+        limbs_add_shifted(ret, z2, 2*m);
+        limbs_normalize(ret);
+        return ret;
+    }
+
+#ifdef __SIZEOF_INT128__
+    // number theoretic transform modulo 2^64 - 2^32 + 1 on base 10^6 digits,
+    // the convolution of up to 2^24 of them can't reach the modulus
+
+    const uint64_t ntt_modulus = 0xFFFFFFFF00000001ull;
+    const uint64_t ntt_generator = 7;
+    const size_t ntt_max_digits = size_t(1) << 24;
+    const uint64_t ntt_digit_base = 1000000;
+    __extension__ typedef unsigned __int128 uint128_t;
+
+    uint64_t ntt_mul(uint64_t A, uint64_t B){
+        uint128_t x = uint128_t(A) * B;
+        uint64_t low = uint64_t(x);
+        uint64_t high = uint64_t(x >> 64);
+        uint64_t high_high = high >> 32;
+        uint64_t high_low = high & 0xFFFFFFFFull;
+        // 2^64 = 2^32 - 1 and 2^96 = -1 modulo the modulus
+        uint64_t t = low - high_high;
+        if(low < high_high){
+            t -= 0xFFFFFFFFull;
+        }
+        uint64_t r = t + high_low * 0xFFFFFFFFull;
+        if(r < t){
+            r += 0xFFFFFFFFull;
+        }
+        return (r >= ntt_modulus) ? r - ntt_modulus : r;
+    }
+
+    uint64_t ntt_add(uint64_t A, uint64_t B){
+        uint64_t r = A + B;
+        if(r < A or r >= ntt_modulus){
+            r -= ntt_modulus;
+        }
+        return r;
+    }
+
+    uint64_t ntt_sub(uint64_t A, uint64_t B){
+        return (A >= B) ? A - B : A + (ntt_modulus - B);
+    }
+
+    uint64_t ntt_pow(uint64_t A, uint64_t P){
+        uint64_t ret = 1;
+        for(; P != 0; P >>= 1){
+            if(P & 1){
+                ret = ntt_mul(ret, A);
+            }
+            A = ntt_mul(A, A);
+        }
+        return ret;
+    }
+
+    void ntt(vector<uint64_t>& A, bool Inverse){
+        size_t n = A.size();
+        for(size_t i = 1, j = 0; i < n; i++){
+            size_t bit = n >> 1;
+            for(; j & bit; bit >>= 1){
+                j ^= bit;
+            }
+            j ^= bit;
+            if(i < j){
+                swap(A[i], A[j]);
+            }
+        }
+        vector<uint64_t> roots(n/2);
+        for(size_t length = 2; length <= n; length <<= 1){
+            uint64_t root = ntt_pow(ntt_generator, (ntt_modulus - 1) / length);
+            if(Inverse){
+                root = ntt_pow(root, ntt_modulus - 2);
+            }
+            size_t half = length / 2;
+            roots[0] = 1;
+            for(size_t k = 1; k < half; k++){
+                roots[k] = ntt_mul(roots[k-1], root);
+            }
+            for(size_t i = 0; i < n; i += length){
+                for(size_t k = 0; k < half; k++){
+                    uint64_t u = A[i+k];
+                    uint64_t v = ntt_mul(A[i+k+half], roots[k]);
+                    A[i+k] = ntt_add(u, v);
+                    A[i+k+half] = ntt_sub(u, v);
+                }
+            }
+        }
+        if(Inverse){
+            uint64_t n_inverse = ntt_pow(n, ntt_modulus - 2);
+            for(size_t i = 0; i < n; i++){
+                A[i] = ntt_mul(A[i], n_inverse);
+            }
+        }
+    }
+
+    // every two limbs of 10^9 make three digits of 10^6
+    void limbs_to_ntt_digits(const Limbs& A, vector<uint64_t>& To){
+        for(size_t i = 0; i < A.size(); i += 2){
+            uint64_t low = A[i];
+            uint64_t high = (i + 1 < A.size()) ? A[i+1] : 0;
+            To.push_back(low % ntt_digit_base);
+            To.push_back(low / ntt_digit_base + (high % 1000) * 1000);
+            To.push_back(high / 1000);
+        }
+    }
+
+    Limbs limbs_ntt_mul(const Limbs& A, const Limbs& B){
+        vector<uint64_t> a;
+        vector<uint64_t> b;
+        limbs_to_ntt_digits(A, a);
+        limbs_to_ntt_digits(B, b);
+        size_t n = 1;
+        while(n < a.size() + b.size()){
+            n <<= 1;
+        }
+        a.resize(n, 0);
+        b.resize(n, 0);
+        ntt(a, false);
+        ntt(b, false);
+        for(size_t i = 0; i < n; i++){
+            a[i] = ntt_mul(a[i], b[i]);
+        }
+        ntt(a, true);
+        uint64_t carry = 0;
+        for(size_t i = 0; i < n; i++){
+            a[i] += carry;
+            carry = a[i] / ntt_digit_base;
+            a[i] %= ntt_digit_base;
+        }
+        Limbs ret;
+        ret.reserve(n / 3 * 2 + 2);
+        for(size_t i = 0; i < n; i += 3){
+            uint64_t d0 = a[i];
+            uint64_t d1 = (i + 1 < n) ? a[i+1] : 0;
+            uint64_t d2 = (i + 2 < n) ? a[i+2] : 0;
+            ret.push_back(d0 + (d1 % 1000) * ntt_digit_base);
+            ret.push_back(d1 / 1000 + d2 * 1000);
+        }
+        limbs_normalize(ret);
+        return ret;
+    }
+#endif
+
+    Limbs limbs_mul(const Limbs& A, const Limbs& B){
+        size_t shorter = min(A.size(), B.size());
+#ifdef __SIZEOF_INT128__
+        if(shorter >= ntt_limbs and (A.size() + B.size()) * 3 / 2 <= ntt_max_digits){
+            return limbs_ntt_mul(A, B);
+        }
+#endif
+        if(shorter >= karatsuba_limbs){
+            return limbs_karatsuba_mul(A, B);
+        }
+        return limbs_schoolbook_mul(A, B);
+    }
+
+    // Knuth's algorithm D, the divisor has at least two limbs
+    Limbs limbs_long_div(const Limbs& U, const Limbs& V){
+        size_t n = V.size();
+        size_t m = U.size() - n;
+        Limb d = limb_base / (V[n-1] + 1);
+        Limbs u = U;
+        Limbs v = V;
+        limbs_mul_small(v, d);
+        u.push_back(0);
+        uint64_t carry = 0;
+        for(size_t i = 0; i < u.size(); i++){
+            uint64_t product = uint64_t(u[i]) * d + carry;
+            u[i] = product % limb_base;
+            carry = product / limb_base;
+        }
+        Limbs q(m+1, 0);
+        for(size_t j = m+1; j-- > 0; ){
+            uint64_t top = uint64_t(u[j+n]) * limb_base + u[j+n-1];
+            uint64_t qhat = top / v[n-1];
+            uint64_t rhat = top % v[n-1];
+            while(qhat >= limb_base or qhat * v[n-2] > rhat * limb_base + u[j+n-2]){
+                qhat--;
+                rhat += v[n-1];
+                if(rhat >= limb_base){
+                    break;
+                }
+            }
+            int64_t borrow = 0;
+            carry = 0;
+            for(size_t i = 0; i < n; i++){
+                uint64_t product = qhat * v[i] + carry;
+                carry = product / limb_base;
+                int64_t t = int64_t(u[i+j]) - int64_t(product % limb_base) - borrow;
+                borrow = (t < 0) ? 1 : 0;
+                u[i+j] = t + borrow * int64_t(limb_base);
+            }
+            int64_t t = int64_t(u[j+n]) - int64_t(carry) - borrow;
+            if(t < 0){
+                // qhat was one too many, add the divisor back
+                qhat--;
+                carry = 0;
+                for(size_t i = 0; i < n; i++){
+                    uint64_t sum = uint64_t(u[i+j]) + v[i] + carry;
+                    u[i+j] = sum % limb_base;
+                    carry = sum / limb_base;
+                }
+                t += carry;
+            }
+            u[j+n] = t;
+            q[j] = qhat;
+        }
+        limbs_normalize(q);
+        return q;
+    }
+
+    void limbs_shift_limbs_up(Limbs& A, size_t Limbs_count){ // A * base^Limbs_count
+        if(not A.empty()){
+            A.insert(A.begin(), Limbs_count, 0);
+        }
+    }
+
+    void limbs_shift_limbs_down(Limbs& A, size_t Limbs_count){ // A / base^Limbs_count
+        A.erase(A.begin(), A.begin() + min(Limbs_count, A.size()));
+    }
+
+    Limbs limbs_power(size_t Limbs_count){ // base^Limbs_count
+        Limbs ret(Limbs_count + 1, 0);
+        ret.back() = 1;
+        return ret;
+    }
+
+    // floor(base^2P / D_P), where D_P is the P most significant limbs of D, by
+    // Newton's iteration X = X + X (base^2P - D_P X) / base^2P. The reciprocal for
+    // a little more than half the limbs is already good for a little less than P
+    // limbs, so a single step brings it to P limbs and few corrections make it exact.
+    Limbs limbs_reciprocal(const Limbs& D, size_t P){
+        Limbs d = limbs_part(D, D.size() - P, D.size());
+        Limbs one = limbs_power(2*P);
+        if(P <= newton_exact_limbs){
+            return limbs_long_div(one, d);
+        }
+        size_t h = (P + 1) / 2 + 2;
+        Limbs x = limbs_reciprocal(D, h);
+        limbs_shift_limbs_up(x, P - h);
+
+        Limbs t = limbs_mul(d, x);
+        bool over = limbs_compare(t, one) > 0;
+        Limbs e = over ? t : one;
+        limbs_sub(e, over ? one : t);
+        Limbs step = limbs_mul(x, e);
+        limbs_shift_limbs_down(step, 2*P);
+        if(over){
+            limbs_add(step, Limbs(1, 1));
+            limbs_sub(x, step);
+        }else{
+            limbs_add(x, step);
+        }
+
+        t = limbs_mul(d, x);
+        while(limbs_compare(t, one) > 0){
+            limbs_sub(x, Limbs(1, 1));
+            limbs_sub(t, d);
+        }
+        limbs_add(t, d);
+        while(limbs_compare(t, one) <= 0){
+            limbs_add(x, Limbs(1, 1));
+            limbs_add(t, d);
+        }
+        return x;
+    }
+
+    // N / D as N times the reciprocal of D, which gets just less than the quotient
+    Limbs limbs_newton_div(const Limbs& N, const Limbs& D){
+        // both are shifted so that N has no more than twice the limbs of D
+        size_t shift = (N.size() > 2 * D.size()) ? N.size() - 2 * D.size() : 0;
+        Limbs n = N;
+        Limbs d = D;
+        limbs_shift_limbs_up(n, shift);
+        limbs_shift_limbs_up(d, shift);
+        Limbs q = limbs_mul(n, limbs_reciprocal(d, d.size()));
+        limbs_shift_limbs_down(q, 2 * d.size());
+        limbs_normalize(q);
+
+        Limbs rest = N;
+        limbs_sub(rest, limbs_mul(q, D));
+        while(limbs_compare(rest, D) >= 0){
+            limbs_sub(rest, D);
+            limbs_add(q, Limbs(1, 1));
+        }
+        return q;
+    }
+
+    Limbs limbs_div(const Limbs& A, const Limbs& B){
+        if(limbs_compare(A, B) < 0){
+            return Limbs();
+        }
+        if(B.size() == 1){
+            Limbs q = A;
+            limbs_div_small(q, B[0]);
+            return q;
+        }
+        if(min(B.size(), A.size() - B.size()) >= newton_limbs){
+            return limbs_newton_div(A, B);
+        }
+        return limbs_long_div(A, B);
+    }
+
+    void limbs_shift_up(Limbs& A, unsigned int Digits){ // A * 10^Digits
+        if(A.empty()){
+            return;
+        }
+        A.insert(A.begin(), Digits / limb_digits, 0);
+        limbs_mul_small(A, powers_of_10[Digits % limb_digits]);
+    }
+
+    void limbs_shift_down(Limbs& A, unsigned int Digits){ // A / 10^Digits
+        A.erase(A.begin(), A.begin() + min<size_t>(Digits / limb_digits, A.size()));
+        limbs_div_small(A, powers_of_10[Digits % limb_digits]);
+    }
+
+    void rescale(Decimal& A, unsigned int Scale){ // Scale >= A.scale
+        limbs_shift_up(A.limbs, Scale - A.scale);
+        A.scale = Scale;
+    }
+
+    void trim(Decimal& A){
+        unsigned int zeros = 0;
+        size_t i = 0;
+        for(; i < A.limbs.size() and A.limbs[i] == 0 and zeros < A.scale; i++){
+            zeros += limb_digits;
+        }
+        if(i < A.limbs.size()){
+            for(Limb l = A.limbs[i]; l % 10 == 0 and zeros < A.scale; l /= 10){
+                zeros++;
+            }
+        }
+        zeros = A.limbs.empty() ? A.scale : min(zeros, A.scale);
+        limbs_shift_down(A.limbs, zeros);
+        A.scale -= zeros;
+        if(A.limbs.empty()){
+            A.negative = false;
+        }
+    }
+
+    bool to_decimal(View S, Decimal& To){
+        To = Decimal();
+        size_t i = 0;
+        if(not S.empty() and S[0] == '-'){
+            To.negative = true;
+            i++;
+        }
+        String digits;
+        digits.reserve(S.length());
+        bool point = false;
+        for(; i < S.length(); i++){
+            if(S[i] >= '0' and S[i] <= '9'){
+                digits += S[i];
+                if(point){
+                    To.scale++;
+                }
+            }else if(S[i] == '.' and not point){
+                point = true;
+            }else{
+                return false;
+            }
+        }
+        if(digits.empty()){
+            return false;
+        }
+        To.limbs.reserve(digits.length() / limb_digits + 1);
+        for(size_t end = digits.length(); end > 0; ){
+            size_t start = (end > limb_digits) ? end - limb_digits : 0;
+            Limb limb = 0;
+            for(size_t j = start; j < end; j++){
+                limb = limb * 10 + (digits[j] - '0');
+            }
+            To.limbs.push_back(limb);
+            end = start;
+        }
+        limbs_normalize(To.limbs);
+        if(To.limbs.empty()){
+            To.negative = false;
+        }
+        return true;
+    }
+
+    String text(const Decimal& A){
+        if(A.product){
+            Decimal trimmed = A;
+            trimmed.product = false;
+            trim(trimmed);
+            return text(trimmed);
+        }
+        String digits;
+        if(A.limbs.empty()){
+            digits = "0";
+        }else{
+            text_into(digits, A.limbs.back());
+            for(size_t i = A.limbs.size()-1; i-- > 0; ){
+                char limb[text_max_length];
+                char* end = text_into(limb, A.limbs[i]);
+                digits.append(limb_digits - (end - limb), '0');
+                digits.append(limb, end);
+            }
+        }
+        if(digits.length() <= A.scale){
+            digits.insert(0, A.scale + 1 - digits.length(), '0');
+        }
+        if(A.scale > 0){
+            digits.insert(digits.length() - A.scale, 1, '.');
+        }
+        return A.negative ? "-" + digits : digits;
+    }
+
+    Decimal decimal_add(const Decimal& A, const Decimal& B){
+        Decimal ret = A;
+        Decimal b = B;
+        if(ret.scale < b.scale){
+            rescale(ret, b.scale);
+        }else{
+            rescale(b, ret.scale);
+        }
+        if(ret.negative == b.negative){
+            limbs_add(ret.limbs, b.limbs);
+        }else if(limbs_compare(ret.limbs, b.limbs) >= 0){
+            limbs_sub(ret.limbs, b.limbs);
+        }else{
+            limbs_sub(b.limbs, ret.limbs);
+            ret.limbs.swap(b.limbs);
+            ret.negative = b.negative;
+        }
+        ret.product = false;
+        trim(ret);
+        return ret;
+    }
+
+    Decimal decimal_negate(const Decimal& A){
+        Decimal ret = A;
+        ret.negative = not A.negative and not A.limbs.empty();
+        return ret;
+    }
+
+    Decimal decimal_sub(const Decimal& A, const Decimal& B){
+        return decimal_add(A, decimal_negate(B));
+    }
+
+    Decimal decimal_mul(const Decimal& A, const Decimal& B){
+        Decimal ret;
+        ret.limbs = limbs_mul(A.limbs, B.limbs);
+        ret.scale = A.scale + B.scale;
+        ret.negative = (A.negative != B.negative) and not ret.limbs.empty();
+        ret.product = true;
+        return ret;
+    }
+
+    // by default the quotient is truncated to as many digits after the point as the operands have
+    const unsigned int auto_precision = UINT_MAX;
+
+    bool decimal_div(const Decimal& A, const Decimal& B, unsigned int Precision, Decimal& To){
+        if(B.limbs.empty()){
+            return false;
+        }
+        Decimal ret;
+        ret.scale = (Precision == auto_precision) ? max(A.scale, B.scale) : Precision;
+        // A 10^scale / B = (A 10^(scale + B.scale)) / (B 10^A.scale)
+        unsigned int common = min(ret.scale + B.scale, A.scale);
+        Limbs divisor = B.limbs;
+        limbs_shift_up(divisor, A.scale - common);
+        ret.limbs = A.limbs;
+        limbs_shift_up(ret.limbs, ret.scale + B.scale - common);
+        ret.limbs = limbs_div(ret.limbs, divisor);
+        ret.negative = (A.negative != B.negative) and not ret.limbs.empty();
+        To.limbs.swap(ret.limbs);
+        To.scale = ret.scale;
+        To.negative = ret.negative;
+        To.product = false;
+        return true;
+    }
+
+
+    // calc
+
+    enum CalcOp{calc_negation, calc_addition, calc_subtraction, calc_multiplication, calc_division};
+
+    bool apply(const CalcOp Op, std::pmr::vector<Decimal>& Stack, const unsigned int Precision){
+        if(Op == calc_negation){
+            Stack.back() = decimal_negate(Stack.back());
+            return true;
+        }
+        Decimal right = move(Stack.back());
+        Stack.pop_back();
+        Decimal& left = Stack.back();
+        switch(Op){
+            case calc_addition: left = decimal_add(left, right); return true;
+            case calc_subtraction: left = decimal_sub(left, right); return true;
+            case calc_multiplication: left = decimal_mul(left, right); return true;
+            default: return decimal_div(left, right, Precision, left);
+        }
+    }
+
+    // fixed point: most expressions are short enough for a 64-bit integer and a
+    // count of digits after the point. Every operation that could get out of
+    // 18 digits fails instead, so calc could start over with decimal arithmetics.
+
+    struct Fixed{
+        int64_t units;
+        unsigned int scale;
+        bool product;
+    };
+
+    const unsigned int fixed_digits = 18;
+    const int64_t fixed_limit = 1000000000000000000LL; // 10^fixed_digits, |units| < fixed_limit
+
+    int64_t fixed_power_of_10(unsigned int Digits){
+        int64_t ret = 1;
+        for(; Digits > 0; Digits--){
+            ret *= 10;
+        }
+        return ret;
+    }
+
+    int64_t units_abs(int64_t A){
+        return (A < 0) ? -A : A;
+    }
+
+    bool units_mul(int64_t A, int64_t B, int64_t& To){ // |A|, |B| <= fixed_limit
+        if(A != 0 and (fixed_limit - 1) / units_abs(A) < units_abs(B)){
+            return false;
+        }
+        To = A * B;
+        return true;
+    }
+
+    bool rescale(Fixed& A, unsigned int Scale){ // Scale >= A.scale
+        if(Scale > fixed_digits or not units_mul(A.units, fixed_power_of_10(Scale - A.scale), A.units)){
+            return false;
+        }
+        A.scale = Scale;
+        return true;
+    }
+
+    void trim(Fixed& A){
+        for(; A.scale > 0 and A.units % 10 == 0; A.scale--){
+            A.units /= 10;
+        }
+        if(A.units == 0){
+            A.scale = 0;
+        }
+    }
+
+    bool to_decimal(View S, Fixed& To){
+        To.units = 0;
+        To.scale = 0;
+        To.product = false;
+        unsigned int digits = 0;
+        bool point = false;
+        for(size_t i = 0; i < S.length(); i++){
+            if(S[i] == '.'){
+                point = true;
+                continue;
+            }
+            if(To.units != 0 or S[i] != '0'){
+                digits++;
+            }
+            To.units = To.units * 10 + (S[i] - '0');
+            if(point){
+                To.scale++;
+            }
+            if(digits == fixed_digits or To.scale > fixed_digits){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    String text(const Fixed& A){
+        if(A.product){
+            Fixed trimmed = A;
+            trimmed.product = false;
+            trim(trimmed);
+            return text(trimmed);
+        }
+        char digits[text_max_length];
+        char* end = to_chars(digits, digits + text_max_length, units_abs(A.units)).ptr;
+        String ret = (A.units < 0) ? "-" : "";
+        size_t length = end - digits;
+        if(length <= A.scale){
+            ret.append(A.scale + 1 - length, '0');
+        }
+        ret.append(digits, end);
+        if(A.scale > 0){
+            ret.insert(ret.length() - A.scale, 1, '.');
+        }
+        return ret;
+    }
+
+    bool fixed_add(const Fixed& A, const Fixed& B, Fixed& To){
+        Fixed a = A;
+        Fixed b = B;
+        if(not rescale(a, max(a.scale, b.scale)) or not rescale(b, a.scale)){
+            return false;
+        }
+        To.units = a.units + b.units;
+        To.scale = a.scale;
+        To.product = false;
+        trim(To);
+        return To.units < fixed_limit and To.units > -fixed_limit;
+    }
+
+    bool fixed_mul(const Fixed& A, const Fixed& B, Fixed& To){
+        if(not units_mul(A.units, B.units, To.units)){
+            return false;
+        }
+        To.scale = A.scale + B.scale;
+        To.product = true;
+        return To.scale <= fixed_digits;
+    }
+
+    bool fixed_div(const Fixed& A, const Fixed& B, unsigned int Precision, Fixed& To){
+        unsigned int scale = (Precision == auto_precision) ? max(A.scale, B.scale) : Precision;
+        if(B.units == 0 or scale > fixed_digits){
+            return false;
+        }
+        // A 10^scale / B = (A 10^(scale + B.scale - A.scale)) / B
+        int64_t dividend = A.units;
+        int64_t divisor = B.units;
+        if(scale + B.scale >= A.scale){
+            if(scale + B.scale - A.scale > fixed_digits or not units_mul(dividend, fixed_power_of_10(scale + B.scale - A.scale), dividend)){
+                return false;
+            }
+        }else if(not units_mul(divisor, fixed_power_of_10(A.scale - scale - B.scale), divisor)){
+            dividend = 0; // the divisor is out of 18 digits, the dividend is not
+        }
+        To.units = dividend / divisor;
+        To.scale = scale;
+        To.product = false;
+        return true;
+    }
+
+    bool apply(const CalcOp Op, std::pmr::vector<Fixed>& Stack, const unsigned int Precision){
+        if(Op == calc_negation){
+            Stack.back().units = -Stack.back().units;
+            return true;
+        }
+        Fixed right = Stack.back();
+        Stack.pop_back();
+        Fixed& left = Stack.back();
+        switch(Op){
+            case calc_addition: return fixed_add(left, right, left);
+            case calc_subtraction: right.units = -right.units; return fixed_add(left, right, left);
+            case calc_multiplication: return fixed_mul(left, right, left);
+            default: return fixed_div(left, right, Precision, left);
+        }
+    }
+
+    bool is_digit(const Char C){
+        return C >= '0' and C <= '9';
+    }
+
+    bool is_name_start(const Char C){
+        return (C >= 'a' and C <= 'z') or (C >= 'A' and C <= 'Z') or C == '_';
+    }
+
+    const size_t max_calc_depth = 1000;
+
+    /*
+    The parser walks the expression once and tells a Sink about every number,
+    name and operation in postfix order. The grammar follows what splitting by
+    '+', '-', '/' and '*' in turn used to do, so '-' binds tighter than '+' and
+    '*' binds tighter than '/':
+
+        sum := difference ('+' difference)*
+        difference := quotient ('-' quotient)*
+        quotient := product ('/' product)*
+        product := unary ('*' unary)*
+        unary := '-'* atom
+        atom := number | name | '(' sum ')'
+    */
+    template <class Sink> class Parser{
+    public:
+        Parser(View Exp, Sink& To) : exp_(Exp), pos_(0), depth_(0), to_(To)
+#ifdef LE_STATS
+            , counts()
+#endif
+        {
+        }
+        bool parse(){
+            return sum() and (peek() == 0 or fail());
+        }
+        size_t pos() const{
+            return pos_;
+        }
+#ifdef LE_STATS
+    private:
+        void count_number(const size_t Digits){
+            counts.numbers++;
+            counts.digits += Digits;
+            counts.max_digits = max(counts.max_digits, Digits);
+        }
+        void count_operation(const CalcOp Op){
+            counts.operations[Op]++;
+        }
+        void count_depth(){
+            counts.max_depth = max(counts.max_depth, depth_);
+        }
+#else
+    private:
+        void count_number(const size_t){
+        }
+        void count_operation(const CalcOp){
+        }
+        void count_depth(){
+        }
+#endif
+        Char peek(){
+            while(pos_ < exp_.length() and (exp_[pos_] == ' ' or exp_[pos_] == '\t')){
+                pos_++;
+            }
+            return (pos_ < exp_.length()) ? exp_[pos_] : 0;
+        }
+        bool fail(){
+            return false;
+        }
+        bool operations(bool (Parser::*Operand)(), const Char Sign, const CalcOp Op){
+            if(not (this->*Operand)()){
+                return false;
+            }
+            while(peek() == Sign){
+                size_t sign_pos = pos_;
+                pos_++;
+                if(not (this->*Operand)()){
+                    return false;
+                }
+                count_operation(Op);
+                if(not to_.operation(Op)){
+                    pos_ = sign_pos;
+                    return false;
+                }
+            }
+            return true;
+        }
+        bool sum(){
+            return operations(&Parser::difference, '+', calc_addition);
+        }
+        bool difference(){
+            return operations(&Parser::quotient, '-', calc_subtraction);
+        }
+        bool quotient(){
+            return operations(&Parser::product, '/', calc_division);
+        }
+        bool product(){
+            return operations(&Parser::unary, '*', calc_multiplication);
+        }
+        bool unary(){
+            bool negative = false;
+            while(peek() == '-'){
+                pos_++;
+                negative = not negative;
+            }
+            if(not atom()){
+                return false;
+            }
+            if(negative){
+                count_operation(calc_negation);
+            }
+            return not negative or to_.operation(calc_negation);
+        }
+        bool atom(){
+            Char c = peek();
+            if(c == '('){
+                if(depth_ == max_calc_depth){
+                    return fail();
+                }
+                pos_++;
+                depth_++;
+                count_depth();
+                if(not sum() or peek() != ')'){
+                    return fail();
+                }
+                pos_++;
+                depth_--;
+                return true;
+            }else if(is_digit(c) or c == '.'){
+                return number();
+            }else if(is_name_start(c)){
+                return name();
+            }
+            return fail();
+        }
+        bool number(){
+            size_t start = pos_;
+            size_t digits = 0;
+            bool point = false;
+            for(; pos_ < exp_.length(); pos_++){
+                if(is_digit(exp_[pos_])){
+                    digits++;
+                }else if(exp_[pos_] == '.' and not point){
+                    point = true;
+                }else{
+                    break;
+                }
+            }
+            if(digits == 0){
+                pos_ = start;
+                return fail();
+            }
+            count_number(digits);
+            return to_.number(exp_.substr(start, pos_-start));
+        }
+        bool name(){
+            size_t start = pos_;
+            while(pos_ < exp_.length() and (is_name_start(exp_[pos_]) or is_digit(exp_[pos_]))){
+                pos_++;
+            }
+            if(not to_.variable(exp_.substr(start, pos_-start))){
+                pos_ = start;
+                return fail();
+            }
+            return true;
+        }
+        View exp_;
+        size_t pos_;
+        size_t depth_;
+        Sink& to_;
+#ifdef LE_STATS
+    public:
+        CalcCounts counts;
+#endif
+    };
+
+    // calculates right away, knows no variables
+    template <class Number> struct Evaluator{
+        Evaluator(const unsigned int Precision, std::pmr::memory_resource* Memory) : stack(Memory), precision(Precision), failed(false){
+            stack.reserve(16);
+        }
+        bool number(View Text){
+            stack.push_back(Number());
+            failed = not to_decimal(Text, stack.back());
+            return not failed;
+        }
+        bool variable(View){
+            return false;
+        }
+        bool operation(const CalcOp Op){
+            failed = not apply(Op, stack, precision);
+            return not failed;
+        }
+        std::pmr::vector<Number> stack;
+        unsigned int precision;
+        bool failed;
+    };
+
+    void calc_failed(const CalcStatus Status, const size_t Offset, const String& Exp, CalcResult& To){
+        To.status = Status;
+        To.offset = Offset;
+        To.error = ((Status == calc_division_by_zero) ? "Division by zero at " : "Syntax error at ") + plain_text(Offset) + " in: \"" + Exp + "\"";
+    }
+
+    void calculate(const String& Exp, const unsigned int Precision, std::pmr::memory_resource* Memory, CalcResult& To){
+        LE_STATS_CALL(stats_calc, Exp.length());
+        Evaluator<Fixed> fast(Precision, Memory);
+        Parser<Evaluator<Fixed>> fast_parser(Exp, fast);
+        if(fast_parser.parse()){
+            To.value = text(fast.stack.back());
+            LE_STATS_CALC(fast_parser, false);
+            LE_STATS_OUT(To.value.length());
+            return;
+        }
+        if(not fast.failed){ // fixed point only gives up on what doesn't fit in it
+            calc_failed(calc_syntax_error, fast_parser.pos(), Exp, To);
+            LE_STATS_CALC(fast_parser, false);
+            return;
+        }
+        Evaluator<Decimal> evaluator(Precision, Memory);
+        Parser<Evaluator<Decimal>> parser(Exp, evaluator);
+        bool parsed = parser.parse();
+        LE_STATS_CALC(parser, true);
+        if(parsed){
+            To.value = text(evaluator.stack.back());
+            LE_STATS_OUT(To.value.length());
+            return;
+        }
+        calc_failed(evaluator.failed ? calc_division_by_zero : calc_syntax_error, parser.pos(), Exp, To);
+    }
+
+    // the cache of calc results, split in shards with a lock and a least recently
+    // used list each, so threads with different expressions rarely wait for each other
+
+    bool is_word(const Char C){
+        return is_digit(C) or is_name_start(C) or C == '.';
+    }
+
+    // spaces only matter between two numbers or names, where they make a syntax error
+    String calc_cache_key(View Exp, const unsigned int Precision){
+        String ret = plain_text(Precision);
+        ret += ':';
+        Char last = ':';
+        bool space = false;
+        for(size_t i = 0; i < Exp.length(); i++){
+            if(Exp[i] == ' ' or Exp[i] == '\t'){
+                space = true;
+                continue;
+            }
+            if(space and is_word(last) and is_word(Exp[i])){
+                ret += ' ';
+            }
+            ret += Exp[i];
+            last = Exp[i];
+            space = false;
+        }
+        return ret;
+    }
+
+    class CalcCacheShard{
+    public:
+        CalcCacheShard() : mutex_(), order_(), index_(), capacity_(0), hits_(0), misses_(0), evictions_(0){
+        }
+        bool find(const String& Key, String& To){
+            lock_guard<mutex> lock(mutex_);
+            Index::iterator it = index_.find(Key);
+            if(it == index_.end()){
+                misses_++;
+                return false;
+            }
+            hits_++;
+            order_.splice(order_.begin(), order_, it->second);
+            To = it->second->second;
+            return true;
+        }
+        void insert(const String& Key, const String& Value){
+            lock_guard<mutex> lock(mutex_);
+            if(capacity_ == 0 or index_.count(Key) != 0){
+                return;
+            }
+            order_.push_front(make_pair(Key, Value));
+            index_[order_.front().first] = order_.begin();
+            if(order_.size() > capacity_){
+                index_.erase(order_.back().first);
+                order_.pop_back();
+                evictions_++;
+            }
+        }
+        void reset(const size_t Capacity){
+            lock_guard<mutex> lock(mutex_);
+            index_.clear();
+            order_.clear();
+            capacity_ = Capacity;
+            hits_ = misses_ = evictions_ = 0;
+        }
+        void add_to(CalcCacheStats& To){
+            lock_guard<mutex> lock(mutex_);
+            To.size += order_.size();
+            To.hits += hits_;
+            To.misses += misses_;
+            To.evictions += evictions_;
+        }
+    private:
+        typedef list<pair<String, String>> Order;
+        typedef unordered_map<View, Order::iterator> Index; // views to the keys in order_
+        mutex mutex_;
+        Order order_;
+        Index index_;
+        size_t capacity_;
+        size_t hits_;
+        size_t misses_;
+        size_t evictions_;
+    };
+
+    const size_t calc_cache_shards = 16;
+    CalcCacheShard calc_cache_shard[calc_cache_shards];
+    atomic<size_t> calc_cache_capacity(0);
+    atomic<size_t> calc_cache_shards_used(1);
+
+    void calc_cache(const size_t Capacity){
+        calc_cache_capacity = 0;
+        // a small cache gets as many shards as it has entries, the capacity is split exactly
+        const size_t shards = max<size_t>(1, min(Capacity, calc_cache_shards));
+        for(size_t i = 0; i < calc_cache_shards; i++){
+            calc_cache_shard[i].reset(i < shards ? Capacity / shards + (i < Capacity % shards ? 1 : 0) : 0);
+        }
+        calc_cache_shards_used = shards;
+        calc_cache_capacity = Capacity;
+    }
+
+    CalcCacheStats calc_cache_stats(){
+        CalcCacheStats ret = {calc_cache_capacity, 0, 0, 0, 0};
+        for(size_t i = 0; i < calc_cache_shards; i++){
+            calc_cache_shard[i].add_to(ret);
+        }
+        return ret;
+    }
+
+    CalcResult calc_result(const String& Exp, const unsigned int Precision, std::pmr::memory_resource* Memory = std::pmr::get_default_resource()){
+        CalcResult ret;
+        if(calc_cache_capacity == 0){
+            calculate(Exp, Precision, Memory, ret);
+            return ret;
+        }
+        String key = calc_cache_key(Exp, Precision);
+        CalcCacheShard& shard = calc_cache_shard[hash<String>()(key) % calc_cache_shards_used];
+        if(not shard.find(key, ret.value)){
+            calculate(Exp, Precision, Memory, ret);
+            if(ret.ok()){
+                shard.insert(key, ret.value);
+            }
+        }
+        return ret;
+    }
+
+    String calc(const String& Exp, const unsigned int Precision){
+        CalcResult ret = calc_result(Exp, Precision);
+        if(ret.status == calc_division_by_zero){
+            throw LEDivByZeroException(ret.error);
+        }else if(ret.status == calc_syntax_error){
+            throw LEExpessionSyntaxException(ret.error);
+        }
+        return ret.value;
+    }
+
     String calc(const String& Exp){
-        String S = replace(Exp, ' ', "");
-        String::iterator SIt = S.begin();
-        String::iterator SItE = S.end();
-        for(; SIt != SItE; ++SIt){
-            if( not (*SIt >= '(' and *SIt <= '9' and *SIt != ',') ){
-                throw LEExpessionSyntaxException("Uncalculatable symbols in: \"" + S + "\"");
-            }
-        }
-
-        size_t ob = S.find_first_of('(');
-        size_t cb = find_matching_bracket( S, ob );
-        if(ob!=String::npos and cb!=String::npos){
-            return calc(S.substr(0, ob) + calc(S.substr(ob+1, cb-ob-1)) + S.substr(cb+1, String::npos));
-        }else if(ob==String::npos and cb==String::npos){
-            vector<String> pluses = split(S, '+');
-            vector<String>::iterator plIt = pluses.begin();
-            vector<String>::iterator plItE = pluses.end();
-            vector<String> calc_pluses;
-            for( ; plIt!=plItE; ++plIt){
-                vector<String> minuses = split(*plIt, '-');
-                vector<String>::iterator miIt = minuses.begin();
-                vector<String>::iterator miItE = minuses.end();
-                vector<String> calc_minuses;
-                for( ; miIt!=miItE; ++miIt){
-                    vector<String> divs = split(*miIt, '/');
-                    vector<String>::iterator diIt = divs.begin();
-                    vector<String>::iterator diItE = divs.end();
-                    vector<String> calc_divs;
-                    for( ; diIt!=diItE; ++diIt){
-                        if((*diIt).find_first_of('*') == String::npos ){
-                            calc_divs.push_back(*diIt);
-                        }else{
-                            vector<String> muls = split(*diIt, '*');
-                            calc_divs.push_back( accumulate(muls.begin()+1, muls.end(), muls[0], mul) );
-                        }
+        return calc(Exp, auto_precision);
+    }
+
+    CalcResult try_calc(const String& Exp, const unsigned int Precision) noexcept{
+        return calc_result(Exp, Precision);
+    }
+
+    CalcResult try_calc(const String& Exp) noexcept{
+        return calc_result(Exp, auto_precision);
+    }
+
+    const size_t calc_batch_grain = 64;
+
+    vector<CalcResult> calc_batch(const vector<String>& Exps){
+        vector<CalcResult> ret(Exps.size());
+        parallel_for(Exps.size(), calc_batch_grain, [&](size_t Begin, size_t End){
+            for(size_t i = Begin; i < End; i++){
+                ret[i] = calc_result(Exps[i], auto_precision);
+            }
+        });
+        return ret;
+    }
+
+
+    // calc_compile
+
+    struct Formula::Program{
+        enum Code{number, variable, operation};
+        struct Op{
+            Code code;
+            size_t arg;
+        };
+        Program() : code(), numbers(), variables(){
+        }
+        vector<Op> code;
+        vector<Decimal> numbers;
+        vector<String> variables;
+    };
+
+    // remembers what to calculate
+    struct Compiler{
+        Compiler(Formula::Program& To) : to(To){
+        }
+        void emit(Formula::Program::Code Code, size_t Arg){
+            Formula::Program::Op op = {Code, Arg};
+            to.code.push_back(op);
+        }
+        bool number(View Text){
+            emit(Formula::Program::number, to.numbers.size());
+            to.numbers.push_back(Decimal());
+            return to_decimal(Text, to.numbers.back());
+        }
+        bool variable(View Name){
+            size_t slot = 0;
+            while(slot < to.variables.size() and to.variables[slot] != Name){
+                slot++;
+            }
+            if(slot == to.variables.size()){
+                to.variables.push_back(String(Name));
+            }
+            emit(Formula::Program::variable, slot);
+            return true;
+        }
+        bool operation(const CalcOp Op){
+            emit(Formula::Program::operation, Op);
+            return true;
+        }
+        Formula::Program& to;
+    };
+
+    Formula::Formula(shared_ptr<const Program> P) : program_(P){
+    }
+
+    Formula calc_compile(const String& Exp){
+        LE_STATS_CALL(stats_calc_compile, Exp.length());
+        shared_ptr<Formula::Program> program(new Formula::Program());
+        Compiler compiler(*program);
+        Parser<Compiler> parser(Exp, compiler);
+        if(not parser.parse()){
+            throw LEExpessionSyntaxException("Syntax error at " + plain_text(parser.pos()) + " in: \"" + Exp + "\"");
+        }
+        return Formula(program);
+    }
+
+    const vector<String>& Formula::variables() const{
+        return program_->variables;
+    }
+
+    String Formula::evaluate(const vector<String>& Values) const{
+        return evaluate(Values, auto_precision);
+    }
+
+    String Formula::evaluate(const vector<String>& Values, const unsigned int Precision) const{
+        LE_STATS_CALL(stats_evaluate, 0);
+        if(Values.size() != program_->variables.size()){
+            throw LEExpessionSyntaxException("Expected " + plain_text(program_->variables.size()) + " values, got " + plain_text(Values.size()));
+        }
+        std::pmr::vector<Decimal> stack;
+        vector<Program::Op>::const_iterator It = program_->code.begin();
+        vector<Program::Op>::const_iterator ItE = program_->code.end();
+        for(; It != ItE; ++It){
+            switch(It->code){
+                case Program::number:
+                    stack.push_back(program_->numbers[It->arg]);
+                    break;
+                case Program::variable:
+                    stack.push_back(Decimal());
+                    if(not to_decimal(Values[It->arg], stack.back())){
+                        throw LEExpessionSyntaxException("Not a number: " + program_->variables[It->arg] + " = \"" + Values[It->arg] + "\"");
+                    }
+                    break;
+                default:
+                    if(not apply(CalcOp(It->arg), stack, Precision)){
+                        throw LEDivByZeroException("Division by zero in a formula");
                     }
-                    calc_minuses.push_back( accumulate(calc_divs.begin()+1, calc_divs.end(), calc_divs[0], div) );
-                }
-                calc_pluses.push_back( accumulate(calc_minuses.begin()+1, calc_minuses.end(), calc_minuses[0], sub) );
             }
-            return accumulate(calc_pluses.begin()+1, calc_pluses.end(), calc_pluses[0], add);
-        }else{
-            throw LEExpessionSyntaxException("Brackets problem in: " + Exp);
+        }
+        String ret = text(stack.back());
+        LE_STATS_OUT(ret.length());
+        return ret;
+    }
+
+    String Formula::evaluate_named(const map<String, String>& Values) const{
+        vector<String> values;
+        values.reserve(program_->variables.size());
+        vector<String>::const_iterator It = program_->variables.begin();
+        vector<String>::const_iterator ItE = program_->variables.end();
+        for(; It != ItE; ++It){
+            map<String, String>::const_iterator value = Values.find(*It);
+            if(value == Values.end()){
+                throw LEExpessionSyntaxException("No value for: " + *It);
+            }
+            values.push_back(value->second);
+        }
+        return evaluate(values);
+    }
+
+
+    // stats snapshot
+
+#ifdef LE_STATS
+
+    Stats stats(){
+        StatsBlock sum;
+        {
+            lock_guard<mutex> lock(stats_registry().lock);
+            stats_merge(sum, stats_registry().finished);
+            list<StatsBlock*>::const_iterator It = stats_registry().blocks.begin();
+            list<StatsBlock*>::const_iterator ItE = stats_registry().blocks.end();
+            for(; It != ItE; ++It){
+                stats_merge(sum, **It);
+            }
+        }
+        Stats ret;
+        ret.enabled = true;
+        for(size_t i = 0; i < stats_functions; i++){
+            FunctionStats function = {stats_names[i], sum.calls[i], sum.nanoseconds[i], sum.bytes_in[i], sum.bytes_out[i]};
+            ret.functions.push_back(function);
+        }
+        ret.calc.numbers = sum.numbers;
+        ret.calc.digits = sum.digits;
+        ret.calc.max_digits = sum.max_digits;
+        ret.calc.negations = sum.operations[calc_negation];
+        ret.calc.additions = sum.operations[calc_addition];
+        ret.calc.subtractions = sum.operations[calc_subtraction];
+        ret.calc.multiplications = sum.operations[calc_multiplication];
+        ret.calc.divisions = sum.operations[calc_division];
+        ret.calc.max_depth = sum.max_depth;
+        ret.calc.long_arithmetic = sum.long_arithmetic;
+        return ret;
+    }
+
+    // the running threads keep counting, so what they count meanwhile may be lost
+    void stats_reset(){
+        lock_guard<mutex> lock(stats_registry().lock);
+        stats_clear(stats_registry().finished);
+        list<StatsBlock*>::const_iterator It = stats_registry().blocks.begin();
+        list<StatsBlock*>::const_iterator ItE = stats_registry().blocks.end();
+        for(; It != ItE; ++It){
+            stats_clear(**It);
+        }
+    }
+
+#else
+
+    Stats stats(){
+        return Stats();
+    }
+
+    void stats_reset(){
+    }
+
+#endif
+
+
+    // pmr
+
+    namespace pmr{
+
+        Strings split(View Line, const Char Coma, std::pmr::memory_resource* Memory){
+            Strings ret(Memory);
+            do_split<Char>(ret, Line, Coma);
+            return ret;
+        }
+
+        Strings split(View Line, View Coma, std::pmr::memory_resource* Memory){
+            Strings ret(Memory);
+            do_split<View>(ret, Line, Coma);
+            return ret;
+        }
+
+        Strings split(View Line, const Pattern& Coma, std::pmr::memory_resource* Memory){
+            Strings ret(Memory);
+            do_split<const Pattern*>(ret, Line, &Coma);
+            return ret;
+        }
+
+        String join(const Strings& Lines, View Coma, std::pmr::memory_resource* Memory){
+            LE_STATS_CALL(stats_join, lines_length(Lines.begin(), Lines.end()));
+            String ret(Memory);
+            join_into(ret, Lines.begin(), Lines.end(), Coma);
+            LE_STATS_OUT(ret.length());
+            return ret;
+        }
+
+        String join(const Strings& Lines, const Char Coma, std::pmr::memory_resource* Memory){
+            LE_STATS_CALL(stats_join, lines_length(Lines.begin(), Lines.end()));
+            String ret(Memory);
+            join_into(ret, Lines.begin(), Lines.end(), Coma);
+            LE_STATS_OUT(ret.length());
+            return ret;
+        }
+
+        String replace(View Line, const Char Coma1, const Char Coma2, std::pmr::memory_resource* Memory){
+            LE_STATS_CALL(stats_replace, Line.length());
+            LE_STATS_OUT(Line.length());
+            String ret(Line, Memory);
+            CharScan scan;
+            for(size_t pos = scan.find(ret, Coma1, 0); pos != String::npos; pos = scan.find(ret, Coma1, pos+1)){
+                ret[pos] = Coma2;
+            }
+            return ret;
+        }
+
+        String replace(View Line, const Char Coma1, View Coma2, std::pmr::memory_resource* Memory){
+            String ret(Memory);
+            do_replace<Char>(ret, Line, Coma1, Coma2);
+            return ret;
+        }
+
+        String replace(View Line, View Coma1, const Char Coma2, std::pmr::memory_resource* Memory){
+            String ret(Memory);
+            do_replace<View>(ret, Line, Coma1, View(&Coma2, 1));
+            return ret;
+        }
+
+        String replace(View Line, View Coma1, View Coma2, std::pmr::memory_resource* Memory){
+            String ret(Memory);
+            do_replace<View>(ret, Line, Coma1, Coma2);
+            return ret;
+        }
+
+        String replace(View Line, const Pattern& Coma1, const Char Coma2, std::pmr::memory_resource* Memory){
+            String ret(Memory);
+            do_replace<const Pattern*>(ret, Line, &Coma1, View(&Coma2, 1));
+            return ret;
+        }
+
+        String replace(View Line, const Pattern& Coma1, View Coma2, std::pmr::memory_resource* Memory){
+            String ret(Memory);
+            do_replace<const Pattern*>(ret, Line, &Coma1, Coma2);
+            return ret;
+        }
+
+        String calc(const LE::String& Exp, std::pmr::memory_resource* Memory){
+            return calc(Exp, auto_precision, Memory);
+        }
+
+        String calc(const LE::String& Exp, const unsigned int Precision, std::pmr::memory_resource* Memory){
+            CalcResult ret = calc_result(Exp, Precision, Memory);
+            if(ret.status == calc_division_by_zero){
+                throw LEDivByZeroException(ret.error);
+            }else if(ret.status == calc_syntax_error){
+                throw LEExpessionSyntaxException(ret.error);
+            }
+            return String(ret.value, Memory);
         }
     }
 }
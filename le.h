@@ -20,12 +20,28 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <sstream>
+#include <istream>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <climits>
+#include <charconv>
+#include <system_error>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 namespace LE{
 
     typedef std::string String;
     typedef char Char;
+    typedef std::basic_string_view<Char> View;
 
     /*
     split makes a vector<String> out of String via Char or String:
@@ -36,6 +52,271 @@ namespace LE{
     std::vector<String> split(const String&, const Char);
     std::vector<String> split(const String&, const String&);
 
+    /*
+    Pattern is a String delimiter prepared for the search once. The search goes with
+    memchr for the rarest of its bytes, such as '!' in an HTML comment, and only
+    compares the whole delimiter there. Delimiters no longer than pattern_short_length
+    are looked for with View::find:
+
+        Pattern cut("<!-- cut -->");
+        split(page, cut) --> [...]
+        replace(page, cut, "<hr>") --> ...
+    */
+    class Pattern{
+    public:
+        explicit Pattern(const String&);
+        size_t find(View Line, size_t Pos = 0) const;
+        size_t length() const{
+            return text_.length();
+        }
+        const String& text() const{
+            return text_;
+        }
+    private:
+        String text_;
+        size_t rare_;
+    };
+
+    const size_t pattern_short_length = 3;
+
+    std::vector<String> split(const String&, const Pattern&);
+
+    /*
+    CharScan looks for a Char in a line 16 or 32 bytes at a time, with SSE2 or,
+    where the processor has it, AVX2. It keeps the matches of the last block, so
+    the next find in the same block is a single bit scan. split and replace by a
+    Char go with it. The positions asked for should only go forward:
+
+        CharScan scan;
+        for(size_t pos = scan.find(line, ','); pos != View::npos; pos = scan.find(line, ',', pos+1)) ...
+    */
+    class CharScan{
+    public:
+        CharScan() : begin_(0), end_(0), mask_(0){
+        }
+        size_t find(View Line, const Char C, size_t Pos = 0){
+            if(Pos >= begin_ and Pos < end_){
+                mask_ &= ~std::uint32_t(0) << (Pos - begin_);
+                if(mask_ != 0){
+                    return begin_ + lowest_bit(mask_);
+                }
+                Pos = end_;
+            }
+            return scan(Line, C, Pos);
+        }
+    private:
+        static unsigned int lowest_bit(const std::uint32_t Mask){ // Mask != 0
+#ifdef _MSC_VER
+            unsigned long ret;
+            _BitScanForward(&ret, Mask);
+            return ret;
+#else
+            return __builtin_ctz(Mask);
+#endif
+        }
+        size_t scan(View Line, const Char C, size_t Pos);
+        size_t begin_; // the block where the matches are
+        size_t end_;
+        std::uint32_t mask_;
+    };
+
+    /*
+    split_view does the same without copying anything. It returns a lazy range
+    of Views into the line, every next token is only looked for when asked:
+
+        for(View token : split_view("something something", ' ')) ...
+
+    The line and the String delimiter should outlive the range.
+    */
+    template <class ComaType> class Tokens{
+    public:
+        class iterator{
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef View value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const View* pointer;
+            typedef const View& reference;
+
+            iterator() : line_(), coma_(), pos_(View::npos), next_(View::npos), token_(), scan_(){
+            }
+            iterator(View Line, ComaType Coma) : line_(Line), coma_(Coma), pos_(0), next_(0), token_(), scan_(){
+                find_next();
+            }
+            reference operator*() const{
+                return token_;
+            }
+            pointer operator->() const{
+                return &token_;
+            }
+            iterator& operator++(){
+                pos_ = next_;
+                if(pos_ != View::npos){
+                    find_next();
+                }
+                return *this;
+            }
+            iterator operator++(int){
+                iterator was = *this;
+                ++*this;
+                return was;
+            }
+            bool operator==(const iterator& It) const{
+                return pos_ == It.pos_;
+            }
+            bool operator!=(const iterator& It) const{
+                return pos_ != It.pos_;
+            }
+        private:
+            void find_next();
+            View line_;
+            ComaType coma_;
+            size_t pos_;
+            size_t next_;
+            View token_;
+            CharScan scan_; // only a Char delimiter is looked for with it
+        };
+
+        Tokens(View Line, ComaType Coma) : line_(Line), coma_(Coma){
+        }
+        iterator begin() const{
+            return iterator(line_, coma_);
+        }
+        iterator end() const{
+            return iterator();
+        }
+    private:
+        View line_;
+        ComaType coma_;
+    };
+
+    // a Char delimiter is looked for right in the loop, with no call per token
+    template <> inline void Tokens<Char>::iterator::find_next(){
+        size_t coma_pos = scan_.find(line_, coma_, pos_);
+        if(coma_pos != View::npos){
+            token_ = line_.substr(pos_, coma_pos-pos_);
+            next_ = coma_pos + 1;
+        }else{
+            token_ = line_.substr(pos_, View::npos);
+            next_ = View::npos;
+        }
+    }
+
+    Tokens<Char> split_view(View, const Char);
+    Tokens<View> split_view(View, View);
+    Tokens<const Pattern*> split_view(View, const Pattern&);
+
+    /*
+    for_each_token calls a function for every token with no copying, the function
+    returns false to stop. for_each_token returns false if it has been stopped:
+
+        for_each_token("key=value;key=value", ';', [](View Token){ ...; return true; })
+
+    split_into splits into a vector that already has some Strings, so their memory
+    is used again. Lines of the same shape are then split with no allocations:
+
+        split_into("something something", ' ', tokens) --> tokens == ["something", "something"]
+    */
+    template <class ComaType, class Function> bool for_each_token(View Line, const ComaType& Coma, Function F){
+        for(View token : split_view(Line, Coma)){
+            if(not F(token)){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<String>& split_into(View Line, const Char Coma, std::vector<String>& To);
+    std::vector<String>& split_into(View Line, View Coma, std::vector<String>& To);
+    std::vector<String>& split_into(View Line, const Pattern& Coma, std::vector<String>& To);
+
+    /*
+    split_any splits by any of the given Chars, every one of them is a delimiter
+    on its own. CharSet is such a set of Chars made once into a table of 256 entries,
+    so the same set splits lazily or into a vector with no setup:
+
+        split_any("key=value; key=value", "=; ") --> ["key", "value", "", "key", "value"]
+        for(View token : split_view(line, CharSet("=; "))) ...
+    */
+    class CharSet{
+    public:
+        explicit CharSet(View Chars = View());
+        bool contains(const Char C) const{
+            return in_[static_cast<unsigned char>(C)];
+        }
+    private:
+        bool in_[UCHAR_MAX + 1];
+    };
+
+    std::vector<String> split_any(View Line, View Comas);
+    Tokens<CharSet> split_view(View, const CharSet&);
+    std::vector<String>& split_into(View Line, const CharSet& Comas, std::vector<String>& To);
+
+    /*
+    split_csv splits a record of comma separated values the RFC 4180 way, in a single
+    pass. A field in double quotes may have delimiters and line breaks in it, and
+    a quote in it is written twice:
+
+        split_csv("1997,Ford,\"Venture \"\"Extended Edition\"\"\",\"4,900.00\"")
+            --> ["1997", "Ford", "Venture \"Extended Edition\"", "4,900.00"]
+
+    Only the first record is split, the line break that ends it is dropped. CsvFields
+    goes through all the records of a text field by field with no copying. The View
+    is into the text, unless the field has doubled quotes, then it is into a buffer
+    that lives until the next call:
+
+        CsvFields fields(text);
+        View field;
+        while(fields.next(field)){
+            ...
+            if(fields.end_of_record()) ...
+        }
+    */
+    class CsvFields{
+    public:
+        explicit CsvFields(View Text, const Char Coma = ',');
+        bool next(View& Field);
+        bool end_of_record() const{
+            return end_of_record_;
+        }
+    private:
+        View text_;
+        Char coma_;
+        CharSet stops_;
+        size_t pos_;
+        bool end_of_record_;
+        bool done_;
+        String unquoted_;
+    };
+
+    std::vector<String> split_csv(View Record, const Char Coma = ',');
+    std::vector<String>& split_csv_into(View Record, const Char Coma, std::vector<String>& To);
+
+    /*
+    StreamTokens splits a stream the same way, token by token. It reads the
+    stream in chunks and keeps no more than a chunk and a token in memory:
+
+        std::ifstream file("huge.tsv");
+        StreamTokens tokens(file, '\t');
+        String token;
+        while(tokens.next(token)) ...
+    */
+    class StreamTokens{
+    public:
+        StreamTokens(std::istream& In, const Char Coma, size_t ChunkSize = 64*1024);
+        StreamTokens(std::istream& In, const String& Coma, size_t ChunkSize = 64*1024);
+        bool next(String& Token);
+    private:
+        bool read_chunk();
+        std::istream& in_;
+        String coma_;
+        size_t chunk_size_;
+        String buffer_;
+        size_t pos_;
+        size_t scanned_;
+        bool done_;
+    };
+
     /*
     join joins it back:
 
@@ -45,6 +326,45 @@ namespace LE{
     String join(const std::vector<String>& Lines, const String& Coma);
     String join(const std::vector<String>& Lines, const Char Coma);
 
+    /*
+    join_into appends the joined lines to a String, reusing its capacity. It takes
+    any forward range of Strings or Views and allocates at most once:
+
+        join_into(To, tokens.begin(), tokens.end(), ", ") --> To + "something, something"
+    */
+    template <class Out, class It> Out& join_into(Out& To, It First, It Last, View Coma){
+        if(First == Last){
+            return To;
+        }
+        size_t length = To.length();
+        for(It it = First; it != Last; ++it){
+            length += View(*it).length() + Coma.length();
+        }
+        To.reserve(length - Coma.length());
+        To.append(View(*First));
+        for(++First; First != Last; ++First){
+            To.append(Coma);
+            To.append(View(*First));
+        }
+        return To;
+    }
+
+    template <class Out, class It> Out& join_into(Out& To, It First, It Last, const Char Coma){
+        return join_into(To, First, Last, View(&Coma, 1));
+    }
+
+    template <class It> String join(It First, It Last, View Coma){
+        String ret;
+        join_into(ret, First, Last, Coma);
+        return ret;
+    }
+
+    template <class It> String join(It First, It Last, const Char Coma){
+        String ret;
+        join_into(ret, First, Last, Coma);
+        return ret;
+    }
+
     /*
     replace replaces stuff in a string:
 
@@ -57,6 +377,93 @@ namespace LE{
     String replace(const String&, const Char, const String&);
     String replace(const String&, const String&, const Char);
     String replace(const String&, const String&, const String&);
+    String replace(const String&, const Pattern&, const Char);
+    String replace(const String&, const Pattern&, const String&);
+
+    /*
+    replace_inplace does the same right in the String. Replacing with something
+    that is not longer than what is replaced never allocates:
+
+        replace_inplace(S = "something something", "thing", "ing") --> "someing someing"
+    */
+    void replace_inplace(String&, const Char, const Char);
+    void replace_inplace(String&, const Char, const String&);
+    void replace_inplace(String&, const String&, const Char);
+    void replace_inplace(String&, const String&, const String&);
+    void replace_inplace(String&, const Pattern&, const Char);
+    void replace_inplace(String&, const Pattern&, const String&);
+
+    /*
+    split, replace and join that get a String or Strings to keep take their memory
+    instead of allocating their own. replace works right in the String, split
+    leaves it to the first token when that takes at least half of it, join appends
+    to the first line, so a chain of them on a temporary goes on in a single buffer:
+
+        join(split(replace(read_line(), '\t', ' '), ' '), ", ")
+    */
+    std::vector<String> split(String&&, const Char);
+    std::vector<String> split(String&&, const String&);
+    std::vector<String> split(String&&, const Pattern&);
+    String replace(String&&, const Char, const Char);
+    String replace(String&&, const Char, const String&);
+    String replace(String&&, const String&, const Char);
+    String replace(String&&, const String&, const String&);
+    String replace(String&&, const Pattern&, const Char);
+    String replace(String&&, const Pattern&, const String&);
+    String join(std::vector<String>&& Lines, const String& Coma);
+    String join(std::vector<String>&& Lines, const Char Coma);
+
+    /*
+    parallel_split and parallel_replace do the same as split and replace on all the
+    cores there are. The line is cut in pieces that are searched at once, and the
+    delimiters that cross from one piece to another are sorted out, so the result
+    is exactly what split and replace give. Lines shorter than parallel_min_length
+    are not worth the threads and go to split and replace as they are:
+
+        parallel_split(log, '\n') --> split(log, '\n')
+        parallel_replace(log, "\r\n", '\n') --> replace(log, "\r\n", '\n')
+    */
+    const size_t parallel_min_length = 1024*1024;
+
+    std::vector<String> parallel_split(const String&, const Char);
+    std::vector<String> parallel_split(const String&, const String&);
+    std::vector<String> parallel_split(const String&, const Pattern&);
+    String parallel_replace(const String&, const Char, const Char);
+    String parallel_replace(const String&, const Char, const String&);
+    String parallel_replace(const String&, const String&, const Char);
+    String parallel_replace(const String&, const String&, const String&);
+    String parallel_replace(const String&, const Pattern&, const Char);
+    String parallel_replace(const String&, const Pattern&, const String&);
+
+    /*
+    replace_all replaces a bunch of things in a single pass. Of the overlapping
+    matches the leftmost wins, and of those starting at the same place the longest:
+
+        replace_all("something something", {{"some", "any"}, {"thing", "one"}}) --> "anyone anyone"
+        replace_all("something", {{"so", "1"}, {"something", "2"}, {"thing", "3"}}) --> "2"
+
+    Replacer keeps the patterns compiled into an Aho-Corasick automaton to reuse
+    it on many strings:
+
+        Replacer placeholders({{"$name", "John"}, {"$city", "Kyiv"}});
+        placeholders("$name from $city") --> "John from Kyiv"
+    */
+    typedef std::vector<std::pair<String, String> > Replacements;
+
+    class Replacer{
+    public:
+        explicit Replacer(const Replacements&);
+        String operator()(View Line) const;
+        String& replace_into(String& To, View Line) const;
+    private:
+        int add_state(size_t Depth);
+        std::vector<int> next_;
+        std::vector<size_t> depth_;
+        std::vector<int> found_;
+        Replacements replacements_;
+    };
+
+    String replace_all(const String&, const Replacements&);
 
     /*
     text and untext both work like boost lexical_cast, I just want them right here:
@@ -73,25 +480,309 @@ namespace LE{
     String text(const float);
     String text(const double);
 
+    /*
+    text_into writes a number to a buffer of text_max_length chars returning the end
+    of it, or appends it to a String. Nothing is allocated, no locale is involved.
+    Floating point numbers get the shortest text that reads back exactly:
+
+        text_into(buf, 0.1) --> buf+3 with "0.1" in buf
+        text_into(S = "x", 42) --> "x42"
+        text_into(S, Ns = [1.5, 2.0, 0.1], ',') --> S + "1.5,2,0.1"
+
+    and text does the same for a whole array at once:
+
+        text(Ns = [1.5, 2.0, 0.1], ',') --> "1.5,2,0.1"
+    */
+    const size_t text_max_length = 32;
+
+    template <class T> char* text_into(char* Buf, const T);
+    template <class T> String& text_into(String&, const T);
+    template <class T> String& text_into(String&, const std::vector<T>&, const Char Coma);
+    template <class T> String text(const std::vector<T>&, const Char Coma);
+
     template <class T>
     T untext(const String& S){
         std::stringstream ss(S);
-        T to;
+        T to = T();
         ss >> to;
         return to;
     }
 
+    /*
+    untext with a place to put the number never throws and never leaves it
+    uninitialized. The whole text should be the number, no spaces or pluses. It
+    returns false otherwise, and Pos tells where the parsing stopped:
+
+        untext("60", i) --> true, i == 60
+        untext("6O", i, Pos) --> false, i == 6, Pos == 1
+
+    The same reads a whole split column reusing the vector, Pos is the index of
+    the first field that is not a number:
+
+        untext(split("1,2,3", ','), Ns) --> true, Ns == [1, 2, 3]
+        untext(split("1,x,3", ','), Ns, Pos) --> false, Pos == 1
+    */
+    template <class T> bool untext(View S, T& To, size_t& Pos){
+        std::from_chars_result parsed = std::from_chars(S.data(), S.data() + S.length(), To);
+        if(parsed.ec != std::errc()){
+            To = T();
+        }
+        Pos = parsed.ptr - S.data();
+        return parsed.ec == std::errc() and Pos == S.length();
+    }
+
+    template <class T> bool untext(View S, T& To){
+        size_t pos;
+        return untext(S, To, pos);
+    }
+
+    template <class Strings, class T> bool untext(const Strings& Ss, std::vector<T>& To, size_t& Pos){
+        To.resize(Ss.size());
+        size_t i = 0;
+        for(typename Strings::const_iterator It = Ss.begin(); It != Ss.end(); ++It, ++i){
+            size_t pos;
+            if(not untext(View(*It), To[i], pos)){
+                Pos = i;
+                return false;
+            }
+        }
+        Pos = i;
+        return true;
+    }
+
+    template <class Strings, class T> bool untext(const Strings& Ss, std::vector<T>& To){
+        size_t pos;
+        return untext(Ss, To, pos);
+    }
+
     /*
     calc calculates an expression in a string returning a string:
 
         calc("2 * ( 4 + 3.00/ (4+3) ) + 1") --> "9.84"
+        calc("1 - (-3)") --> "4"
 
-    NB: calc uses char based decimal arithmetics and this means two things.
-        You don't have to worry about owerflows and type casting, which is good.
-        But it works rather slow, which is not so good. It is best to use it in
-        some sort of config reading or user input processing.
+    NB: calc uses exact decimal arithmetics on numbers of any length, so you don't
+        have to worry about owerflows and type casting. Sums, differences and
+        products are exact, quotients are truncated to as many digits after the
+        point as the operands have. A product keeps all its digits after the
+        point for a division that follows, but is written out without trailing
+        zeros. While everything fits in 18 digits, calc
+        works on native integers, it only goes for long arithmetics when it has
+        to. It is still way slower than native numbers.
     */
     String calc(const String&);
+
+    /*
+    calc with a precision truncates quotients to that many digits after the point:
+
+        calc("2 * ( 4 + 3.00/ (4+3) ) + 1", 5) --> "9.85714"
+    */
+    String calc(const String&, const unsigned int Precision);
+
+    /*
+    try_calc calculates an expression like calc does, but never throws. What went
+    wrong comes in the result along with the offset in the expression where it did:
+
+        try_calc("2 * (4 + 3)").value --> "14"
+        try_calc("2 * (4 + )").status --> calc_syntax_error
+        try_calc("2 * (4 + )").offset --> 9
+        try_calc("1 / (2 - 2)").status --> calc_division_by_zero
+        try_calc("1 / (2 - 2)").error --> "Division by zero at 2 in: \"1 / (2 - 2)\""
+    */
+    enum CalcStatus{calc_done, calc_syntax_error, calc_division_by_zero};
+
+    struct CalcResult{
+        CalcResult() : value(), error(), status(calc_done), offset(0){
+        }
+        String value;
+        String error;
+        CalcStatus status;
+        size_t offset;
+        bool ok() const{
+            return status == calc_done;
+        }
+    };
+
+    CalcResult try_calc(const String&) noexcept;
+    CalcResult try_calc(const String&, const unsigned int Precision) noexcept;
+
+    /*
+    calc_batch calculates a lot of expressions on all the cores there are. The
+    results come in the order of the expressions, the ones that fail get an error
+    instead of a value:
+
+        Exps = ["1+1", "2/0", "3*3"]
+        calc_batch(Exps)[0].value --> "2"
+        calc_batch(Exps)[1].error --> "Division by zero at 1 in: \"2/0\""
+        calc_batch(Exps.begin()+1, Exps.end())[1].value --> "9"
+    */
+    std::vector<CalcResult> calc_batch(const std::vector<String>&);
+    template <class It> std::vector<CalcResult> calc_batch(It Begin, It End){
+        return calc_batch(std::vector<String>(Begin, End));
+    }
+
+    /*
+    calc_cache keeps the results of the latest calc calls, so an expression that
+    comes again, even with other spaces in it, is only looked up. The cache is
+    shared between threads and is off until it gets a capacity and never holds
+    more results than that. So that threads don't wait on each other, it is
+    split into up to 16 parts by the hash of an expression, and every part drops
+    its own least recently used result, which is not always the least recently
+    used one of the whole cache. Zero turns it off again and empties it:
+
+        calc_cache(4096);
+        calc("2 * (4 + 3)") --> "14"
+        calc("2*(4+3)") --> "14"
+        calc_cache_stats().hits --> 1
+    */
+    struct CalcCacheStats{
+        size_t capacity;
+        size_t size;
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+    };
+
+    void calc_cache(const size_t Capacity);
+    CalcCacheStats calc_cache_stats();
+
+    /*
+    calc_tuning tells where calc switches from schoolbook multiplication to Karatsuba,
+    and from Karatsuba to the number theoretic transform. The thresholds are the
+    digits in the shorter operand. Division switches from the long one to Newton's
+    reciprocal iteration when both the divisor and the quotient are that long.
+    The defaults are where the calc/product and calc/quotient sweeps of le_bench
+    cross over on x86-64:
+
+        CalcTuning tuning = calc_tuning();
+        tuning.karatsuba_digits = 1000;
+        calc_tuning(tuning);
+    */
+    const size_t default_karatsuba_digits = 1000;
+    const size_t default_ntt_digits = 40000;
+    const size_t default_newton_digits = 30000;
+
+    struct CalcTuning{
+        size_t karatsuba_digits;
+        size_t ntt_digits;
+        size_t newton_digits;
+    };
+
+    CalcTuning calc_tuning();
+    void calc_tuning(const CalcTuning&);
+
+    /*
+    calc_compile parses an expression once, so it could be calculated again and again
+    with no parsing at all. Names in the expression are variables. Their values go to
+    evaluate in the order the names first appear in the expression, or by name to
+    evaluate_named:
+
+        Formula price = calc_compile("base * (1 + tax) - discount");
+        price.variables() --> ["base", "tax", "discount"]
+        price.evaluate(["100", "0.2", "5"]) --> "115"
+        price.evaluate_named(["base": "100", "tax": "0.2", "discount": "5"]) --> "115"
+
+    A Formula is immutable, so it may be shared and evaluated by many threads.
+    */
+    class Formula{
+    public:
+        const std::vector<String>& variables() const;
+        String evaluate(const std::vector<String>& Values) const;
+        String evaluate(const std::vector<String>& Values, const unsigned int Precision) const;
+        String evaluate_named(const std::map<String, String>& Values) const;
+        struct Program;
+    private:
+        friend Formula calc_compile(const String&);
+        explicit Formula(std::shared_ptr<const Program>);
+        std::shared_ptr<const Program> program_;
+    };
+
+    Formula calc_compile(const String&);
+
+    /*
+    stats tells how many times split, join, replace, replace_all, text, calc,
+    calc_compile and evaluate have been called, for how long, and how many bytes
+    they have read and written. For calc it also counts the numbers and their
+    digits, the operations, the deepest parentheses, and how many expressions
+    needed long arithmetics. Every thread counts on its own, stats sums it all up,
+    stats_reset starts over:
+
+        stats().functions[0].name --> "split"
+        stats().calc.max_depth --> 2
+
+    The counting is only compiled in with LE_STATS defined, otherwise stats comes
+    empty with enabled == false and nothing is counted at all.
+    */
+    struct FunctionStats{
+        String name;
+        size_t calls;
+        size_t nanoseconds;
+        size_t bytes_in;
+        size_t bytes_out;
+    };
+
+    struct CalcStats{
+        CalcStats() : numbers(0), digits(0), max_digits(0), negations(0), additions(0), subtractions(0), multiplications(0), divisions(0), max_depth(0), long_arithmetic(0){
+        }
+        size_t numbers;
+        size_t digits;
+        size_t max_digits;
+        size_t negations;
+        size_t additions;
+        size_t subtractions;
+        size_t multiplications;
+        size_t divisions;
+        size_t max_depth;
+        size_t long_arithmetic;
+    };
+
+    struct Stats{
+        Stats() : enabled(false), functions(), calc(){
+        }
+        bool enabled;
+        std::vector<FunctionStats> functions;
+        CalcStats calc;
+    };
+
+    Stats stats();
+    void stats_reset();
+
+    /*
+    LE::pmr has split, join, replace and calc that take memory from a given
+    std::pmr::memory_resource, so all the text work for a request could go to one
+    arena and be given back at once:
+
+        std::pmr::monotonic_buffer_resource arena;
+        pmr::split("something something", ' ', &arena) --> ["something", "something"]
+        pmr::join(tokens, ", ", &arena) --> "something, something"
+        pmr::replace("something", "some", "no", &arena) --> "nothing"
+        pmr::replace("something something", "thing", '?', &arena) --> "some? some?"
+        pmr::calc("2 * (4 + 3)", &arena) --> "14"
+
+    Tokens, results and calc's working stack come from the resource. Numbers past
+    18 digits in calc still take their limbs from the heap.
+    */
+    namespace pmr{
+        typedef std::pmr::string String;
+        typedef std::pmr::vector<String> Strings;
+
+        Strings split(View Line, const Char Coma, std::pmr::memory_resource* Memory);
+        Strings split(View Line, View Coma, std::pmr::memory_resource* Memory);
+        Strings split(View Line, const Pattern& Coma, std::pmr::memory_resource* Memory);
+
+        String join(const Strings& Lines, View Coma, std::pmr::memory_resource* Memory);
+        String join(const Strings& Lines, const Char Coma, std::pmr::memory_resource* Memory);
+
+        String replace(View Line, const Char Coma1, const Char Coma2, std::pmr::memory_resource* Memory);
+        String replace(View Line, const Char Coma1, View Coma2, std::pmr::memory_resource* Memory);
+        String replace(View Line, View Coma1, const Char Coma2, std::pmr::memory_resource* Memory);
+        String replace(View Line, View Coma1, View Coma2, std::pmr::memory_resource* Memory);
+        String replace(View Line, const Pattern& Coma1, const Char Coma2, std::pmr::memory_resource* Memory);
+        String replace(View Line, const Pattern& Coma1, View Coma2, std::pmr::memory_resource* Memory);
+
+        String calc(const LE::String& Exp, std::pmr::memory_resource* Memory);
+        String calc(const LE::String& Exp, const unsigned int Precision, std::pmr::memory_resource* Memory);
+    }
 }
 
 #endif
@@ -0,0 +1,445 @@
+/*
+    Copyright 2013 Alexandr Kalenuk (akalenuk@gmail.com)
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+    le_bench measures every public function on synthetic text and prints a JSON
+    object per benchmark per line:
+
+        le_bench [filter] [seconds]
+
+    Only the benchmarks with the filter in their name run, each one for at least
+    that many seconds, 0.1 by default.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory_resource>
+#include <new>
+#include <random>
+#include <sstream>
+#include "le.h"
+
+using namespace std;
+
+// every allocation is counted to tell allocations per operation
+
+atomic<size_t> allocations(0);
+
+void* operator new(size_t Size){
+    allocations.fetch_add(1, memory_order_relaxed);
+    void* ret = malloc(Size == 0 ? 1 : Size);
+    if(ret == nullptr){
+        throw bad_alloc();
+    }
+    return ret;
+}
+
+void operator delete(void* Ptr) noexcept{
+    free(Ptr);
+}
+
+void operator delete(void* Ptr, size_t) noexcept{
+    free(Ptr);
+}
+
+void* operator new(size_t Size, align_val_t Alignment){
+    allocations.fetch_add(1, memory_order_relaxed);
+    size_t alignment = static_cast<size_t>(Alignment);
+    void* ret = aligned_alloc(alignment, (Size + alignment - 1) / alignment * alignment);
+    if(ret == nullptr){
+        throw bad_alloc();
+    }
+    return ret;
+}
+
+void operator delete(void* Ptr, align_val_t) noexcept{
+    free(Ptr);
+}
+
+void operator delete(void* Ptr, size_t, align_val_t) noexcept{
+    free(Ptr);
+}
+
+namespace LE{
+
+    // running
+
+    String filter;
+    double min_seconds = 0.1;
+    size_t sink = 0; // what the benchmarks return goes here, so they can't be optimized away
+
+    template <class Function> void bench(const String& Name, const String& Corpus, size_t Bytes, Function F){
+        if(Name.find(filter) == String::npos){
+            return;
+        }
+        sink += F();
+        for(size_t iterations = 1; ; iterations *= 2){
+            size_t allocations_before = allocations;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for(size_t i = 0; i < iterations; i++){
+                sink += F();
+            }
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if(seconds < min_seconds){
+                continue;
+            }
+            cout << "{\"name\": \"" << Name << "\", \"corpus\": \"" << Corpus << "\", \"bytes\": " << Bytes
+                 << ", \"iterations\": " << iterations
+                 << ", \"ns_per_op\": " << seconds * 1e9 / iterations
+                 << ", \"bytes_per_s\": " << Bytes * iterations / seconds
+                 << ", \"allocs_per_op\": " << static_cast<double>(allocations - allocations_before) / iterations << "}" << endl;
+            return;
+        }
+    }
+
+
+    // corpora
+
+    const String long_coma = "<!-- cut -->";
+
+    struct Corpus{
+        String name;
+        String by_char;    // fields separated by ','
+        String by_string;  // the same fields separated by long_coma
+    };
+
+    Corpus make_corpus(const String& Name, size_t Length, size_t FieldLength, mt19937& Random){
+        Corpus ret = {Name, "", ""};
+        while(ret.by_char.length() < Length){
+            size_t length = 1 + Random() % (2 * FieldLength - 1);
+            String field;
+            for(size_t i = 0; i < length; i++){
+                field += static_cast<Char>('a' + Random() % 26);
+            }
+            if(not ret.by_char.empty()){
+                ret.by_char += ',';
+                ret.by_string += long_coma;
+            }
+            ret.by_char += field;
+            ret.by_string += field;
+        }
+        return ret;
+    }
+
+    // paragraphs of words with some markup, CRLF line breaks and a cut every 64 paragraphs or so
+    String make_page(size_t Length, mt19937& Random){
+        String ret;
+        while(ret.length() < Length){
+            ret += "<p class=\"text\">";
+            size_t words = 5 + Random() % 40;
+            for(size_t i = 0; i < words; i++){
+                String word;
+                size_t length = 1 + Random() % 9;
+                for(size_t j = 0; j < length; j++){
+                    word += static_cast<Char>('a' + Random() % 26);
+                }
+                if(Random() % 8 == 0){
+                    word = "<a href=\"/" + word + "\">" + word + "</a>";
+                }
+                ret += word + ((i + 1 < words) ? " " : ".</p>\r\n");
+            }
+            if(Random() % 64 == 0){
+                ret += long_coma + "\r\n";
+            }
+        }
+        return ret;
+    }
+
+    String make_number(size_t Digits, mt19937& Random){
+        String ret(1, static_cast<Char>('1' + Random() % 9));
+        while(ret.length() < Digits){
+            ret += static_cast<Char>('0' + Random() % 10);
+        }
+        return ret;
+    }
+
+
+    // split, join, replace
+
+    void bench_text(const Corpus& C){
+        const String& line = C.by_char;
+        const String& long_line = C.by_string;
+        const Pattern pattern(long_coma);
+        const vector<String> tokens = split(line, ',');
+        const size_t bytes = line.length();
+        const size_t long_bytes = long_line.length();
+
+        bench("split/char", C.name, bytes, [&]{ return split(line, ',').size(); });
+        bench("split/string", C.name, long_bytes, [&]{ return split(long_line, long_coma).size(); });
+        bench("split/pattern", C.name, long_bytes, [&]{ return split(long_line, pattern).size(); });
+        bench("split_view/char", C.name, bytes, [&]{
+            size_t n = 0;
+            for(View token : split_view(line, ',')){
+                n += token.length();
+            }
+            return n;
+        });
+        bench("split_view/string", C.name, long_bytes, [&]{
+            size_t n = 0;
+            for(View token : split_view(long_line, View(long_coma))){
+                n += token.length();
+            }
+            return n;
+        });
+        bench("for_each_token/char", C.name, bytes, [&]{
+            size_t n = 0;
+            for_each_token(line, ',', [&n](View Token){ n += Token.length(); return true; });
+            return n;
+        });
+        bench("split_any/chars", C.name, bytes, [&]{ return split_any(line, ",;").size(); });
+        const CharSet comas(",;");
+        bench("split_view/char_set", C.name, bytes, [&]{
+            size_t n = 0;
+            for(View token : split_view(line, comas)){
+                n += token.length();
+            }
+            return n;
+        });
+        bench("split_csv", C.name, bytes, [&]{ return split_csv(line).size(); });
+        bench("csv_fields", C.name, bytes, [&]{
+            CsvFields fields(line);
+            size_t n = 0;
+            for(View field; fields.next(field); ){
+                n += field.length();
+            }
+            return n;
+        });
+        vector<String> into;
+        bench("split_into/char", C.name, bytes, [&]{ return split_into(line, ',', into).size(); });
+        bench("split_into/string", C.name, long_bytes, [&]{ return split_into(long_line, View(long_coma), into).size(); });
+        bench("stream_tokens/char", C.name, bytes, [&]{
+            istringstream in(line);
+            StreamTokens stream(in, ',');
+            String token;
+            size_t n = 0;
+            while(stream.next(token)){
+                n++;
+            }
+            return n;
+        });
+
+        bench("join/char", C.name, bytes, [&]{ return join(tokens, ',').length(); });
+        bench("join/string", C.name, long_bytes, [&]{ return join(tokens, long_coma).length(); });
+        String joined;
+        bench("join_into/views", C.name, bytes, [&]{
+            Tokens<Char> views = split_view(line, ',');
+            joined.clear();
+            return join_into(joined, views.begin(), views.end(), ';').length();
+        });
+
+        bench("replace/char_char", C.name, bytes, [&]{ return replace(line, ',', ';').length(); });
+        bench("replace/char_string", C.name, bytes, [&]{ return replace(line, ',', long_coma).length(); });
+        bench("replace/string_char", C.name, long_bytes, [&]{ return replace(long_line, long_coma, ',').length(); });
+        bench("replace/string_string", C.name, long_bytes, [&]{ return replace(long_line, long_coma, String(", ")).length(); });
+        bench("replace/pattern", C.name, long_bytes, [&]{ return replace(long_line, pattern, String(", ")).length(); });
+        String inplace;
+        bench("replace_inplace/char", C.name, bytes, [&]{
+            inplace = line;
+            replace_inplace(inplace, ',', ';');
+            return inplace.length();
+        });
+        bench("replace_inplace/string", C.name, long_bytes, [&]{
+            inplace = long_line;
+            replace_inplace(inplace, long_coma, String(", "));
+            return inplace.length();
+        });
+        bench("replace/moved", C.name, long_bytes, [&]{
+            inplace = long_line;
+            inplace = replace(std::move(inplace), long_coma, String(", "));
+            return inplace.length();
+        });
+        bench("split_join/moved", C.name, bytes, [&]{
+            inplace = line;
+            inplace = join(split(std::move(inplace), ','), ';');
+            return inplace.length();
+        });
+        Replacements replacements;
+        replacements.push_back(make_pair(String("ab"), String("AB")));
+        replacements.push_back(make_pair(String("abc"), String("x")));
+        replacements.push_back(make_pair(String(","), String(", ")));
+        const Replacer replacer(replacements);
+        bench("replace_all", C.name, bytes, [&]{ return replace_all(line, replacements).length(); });
+        bench("replacer", C.name, bytes, [&]{ return replacer(line).length(); });
+
+        char buffer[64 * 1024];
+        bench("pmr/split", C.name, bytes, [&]{
+            std::pmr::monotonic_buffer_resource arena(buffer, sizeof buffer);
+            return pmr::split(line, ',', &arena).size();
+        });
+        bench("pmr/replace", C.name, long_bytes, [&]{
+            std::pmr::monotonic_buffer_resource arena(buffer, sizeof buffer);
+            return pmr::replace(long_line, View(long_coma), ", ", &arena).length();
+        });
+    }
+
+
+    // a Pattern against a String delimiter on a page with a lot of markup
+
+    void bench_pattern(const String& Page){
+        const Pattern cut(long_coma);
+        const String crlf = "\r\n";
+        const Pattern crlf_pattern(crlf);
+        const size_t bytes = Page.length();
+
+        bench("pattern/split_string", "page", bytes, [&]{ return split(Page, long_coma).size(); });
+        bench("pattern/split_pattern", "page", bytes, [&]{ return split(Page, cut).size(); });
+        bench("pattern/replace_string", "page", bytes, [&]{ return replace(Page, long_coma, String("<hr>")).length(); });
+        bench("pattern/replace_pattern", "page", bytes, [&]{ return replace(Page, cut, String("<hr>")).length(); });
+        bench("pattern/split_string_crlf", "page", bytes, [&]{ return split(Page, crlf).size(); });
+        bench("pattern/split_pattern_crlf", "page", bytes, [&]{ return split(Page, crlf_pattern).size(); });
+    }
+
+
+    // split and replace on a single huge line
+
+    void bench_parallel(const Corpus& C){
+        const String& line = C.by_char;
+        const String& long_line = C.by_string;
+        const size_t bytes = line.length();
+        const size_t long_bytes = long_line.length();
+
+        bench("parallel/split", C.name, bytes, [&]{ return split(line, ',').size(); });
+        bench("parallel/parallel_split", C.name, bytes, [&]{ return parallel_split(line, ',').size(); });
+        bench("parallel/replace", C.name, long_bytes, [&]{ return replace(long_line, long_coma, String(", ")).length(); });
+        bench("parallel/parallel_replace", C.name, long_bytes, [&]{ return parallel_replace(long_line, long_coma, String(", ")).length(); });
+    }
+
+
+    // text, untext
+
+    void bench_numbers(mt19937& Random){
+        vector<int> ints;
+        vector<double> doubles;
+        for(size_t i = 0; i < 1000; i++){
+            ints.push_back(static_cast<int>(Random() % 2000000) - 1000000);
+            doubles.push_back(static_cast<double>(Random()) / (Random() + 1));
+        }
+        const String int_line = text(ints, ',');
+        const String double_line = text(doubles, ',');
+        const vector<String> int_texts = split(int_line, ',');
+        const vector<String> double_texts = split(double_line, ',');
+        const size_t int_bytes = int_line.length() / ints.size();
+        const size_t double_bytes = double_line.length() / doubles.size();
+        size_t i = 0;
+        char buffer[text_max_length];
+        String line;
+
+        bench("text/int", "1000 ints", int_bytes, [&]{ return text(ints[i++ % ints.size()]).length(); });
+        bench("text/double", "1000 doubles", double_bytes, [&]{ return text(doubles[i++ % doubles.size()]).length(); });
+        bench("text_into/double", "1000 doubles", double_bytes, [&]{ return static_cast<size_t>(text_into(buffer, doubles[i++ % doubles.size()]) - buffer); });
+        bench("text/vector", "1000 doubles", double_line.length(), [&]{
+            line.clear();
+            return text_into(line, doubles, ',').length();
+        });
+        bench("untext/int", "1000 ints", int_bytes, [&]{ return static_cast<size_t>(untext<int>(int_texts[i++ % int_texts.size()])); });
+        double parsed = 0;
+        bench("untext_into/double", "1000 doubles", double_bytes, [&]{ return static_cast<size_t>(untext(double_texts[i++ % double_texts.size()], parsed)); });
+        vector<double> column;
+        bench("untext/column", "1000 doubles", double_line.length(), [&]{
+            untext(double_texts, column);
+            return column.size();
+        });
+    }
+
+
+    // calc
+
+    // products and quotients of growing length under every algorithm, the defaults
+    // of CalcTuning are where one starts to win over the other:
+    //     schoolbook, karatsuba/one level - one Karatsuba step on schoolbook halves
+    //     karatsuba, ntt - Karatsuba down to the default threshold against the NTT
+    //     long, newton - long division against Newton's reciprocal
+    void bench_calc_tuning(mt19937& Random){
+        const CalcTuning defaults = calc_tuning();
+        const size_t never = numeric_limits<size_t>::max();
+        const size_t sweep[] = {200, 300, 500, 700, 1000, 1500, 2000, 5000, 10000, 20000, 50000};
+        for(size_t digits : sweep){
+            const String a = make_number(digits, Random);
+            const String b = make_number(digits, Random);
+            const String product = a + " * " + b;
+            const String quotient = a + b + " / " + b;
+            const String corpus = to_string(digits) + " digits, ";
+            const pair<String, CalcTuning> products[] = {
+                {"schoolbook", {never, never, never}},
+                {"karatsuba/one level", {digits, never, never}},
+                {"karatsuba", {defaults.karatsuba_digits, never, never}},
+                {"ntt", {defaults.karatsuba_digits, digits, never}}};
+            for(const pair<String, CalcTuning>& p : products){
+                calc_tuning(p.second);
+                bench("calc/product", corpus + p.first, product.length(), [&]{ return calc(product).length(); });
+            }
+            const pair<String, CalcTuning> quotients[] = {
+                {"long", {defaults.karatsuba_digits, defaults.ntt_digits, never}},
+                {"newton", {defaults.karatsuba_digits, defaults.ntt_digits, digits}}};
+            for(const pair<String, CalcTuning>& q : quotients){
+                calc_tuning(q.second);
+                bench("calc/quotient", corpus + q.first, quotient.length(), [&]{ return calc(quotient).length(); });
+            }
+        }
+        calc_tuning(defaults);
+    }
+
+    void bench_calc(mt19937& Random){
+        const String small = "2 * ( 4 + 3.00/ (4+3) ) + (2 - 1) + 1";
+        const String a = make_number(1000, Random);
+        const String b = make_number(1000, Random);
+        const String sum = a + " + " + b;
+
+        bench("calc/small", "small", small.length(), [&]{ return calc(small).length(); });
+        bench("calc/sum", "1000 digits", sum.length(), [&]{ return calc(sum).length(); });
+        bench("calc/precision", "small", 3, [&]{ return calc("1/3", 1000).length(); });
+        bench("try_calc/error", "small", 11, [&]{ return try_calc("2 * (4 + x)").offset; });
+        calc_cache(1024);
+        bench("calc/cached", "small", small.length(), [&]{ return calc(small).length(); });
+        calc_cache(0);
+        const vector<String> batch(1000, small);
+        bench("calc_batch", "1000 small", small.length() * batch.size(), [&]{ return calc_batch(batch).size(); });
+        const Formula formula = calc_compile("2 * ( x + 3.00/ (x+3) ) + (2 - y) + 1");
+        const vector<String> values = {"4", "1"};
+        bench("calc_compile/evaluate", "small", small.length(), [&]{ return formula.evaluate(values).length(); });
+        char buffer[4 * 1024];
+        bench("pmr/calc", "small", small.length(), [&]{
+            std::pmr::monotonic_buffer_resource arena(buffer, sizeof buffer);
+            return pmr::calc(small, &arena).length();
+        });
+    }
+}
+
+int main(int argc, char* argv[]){
+    if(argc > 1){
+        LE::filter = argv[1];
+    }
+    if(argc > 2){
+        LE::min_seconds = atof(argv[2]);
+    }
+    mt19937 random(2013);
+    LE::bench_text(LE::make_corpus("short_few", 80, 20, random));
+    LE::bench_text(LE::make_corpus("short_many", 80, 2, random));
+    LE::bench_text(LE::make_corpus("long_few", 64 * 1024, 40, random));
+    LE::bench_text(LE::make_corpus("long_many", 64 * 1024, 3, random));
+    const LE::String parallel_names = "parallel/split parallel/parallel_split parallel/replace parallel/parallel_replace";
+    if(parallel_names.find(LE::filter) != LE::String::npos){ // the corpus alone takes a while
+        LE::bench_parallel(LE::make_corpus("huge", 64 * 1024 * 1024, 40, random));
+    }
+    LE::bench_pattern(LE::make_page(4 * 1024 * 1024, random));
+    LE::bench_numbers(random);
+    LE::bench_calc(random);
+    LE::bench_calc_tuning(random);
+    return LE::sink == 0; // nothing has run
+}
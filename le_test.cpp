@@ -15,6 +15,7 @@
 */
 
 #include <iostream>
+#include <sstream>
 #include "le.h"
 
 using namespace std;
@@ -32,19 +33,135 @@ namespace LE{
         string joined = LE::join(test_vector, '*');
         cout << "\tjoin by char - " << (joined == "* and *y things. <* href='*y*'>!") << "\n";
 
+        splitted = LE::split("dirt and dirty things. <dirt href='dirtydirt'>!", LE::Pattern("dirt"));
+        cout << "\tsplit by pattern - " << (splitted == test_vector) << "\n";
+
         splitted = LE::split(joined, '*');
         cout << "\tsplit by char - " << (splitted == test_vector) << "\n";
 
+        LE::split_into("a,b,c,d", ',', splitted);
+        cout << "\tsplit_into - " << (LE::split_into(joined, '*', splitted) == test_vector) << "\n";
+
+        size_t visited = 0;
+        bool finished = LE::for_each_token(joined, '*', [&visited](LE::View Token){ visited++; return Token != "y"; });
+        cout << "\tfor_each_token - " << (not finished and visited == 5) << "\n";
+
+        const string any_array[5] = {"key", "value", "", "key", "value"};
+        cout << "\tsplit_any - " << (LE::split_any("key=value; key=value", "=; ") == vector<string>(any_array, any_array+5)) << "\n";
+
+        const string csv_array[4] = {"1997", "Ford", "Venture \"Extended Edition\"", "4,900.00"};
+        cout << "\tsplit_csv - " << (LE::split_csv("1997,Ford,\"Venture \"\"Extended Edition\"\"\",\"4,900.00\"\r\n") == vector<string>(csv_array, csv_array+4)) << "\n";
+        const string csv_buffer = "a,b,\"x\"";
+        cout << "\tsplit_csv of a part - " << (LE::split_csv(LE::View(csv_buffer.data(), 4)) == LE::split("a,b,", ',')) << "\n";
+
         joined = LE::join(splitted, "icecream");
         cout << "\tjoin by string - " << (joined == "icecream and icecreamy things. <icecream href='icecreamyicecream'>!") << "\n";
+        vector<string> viewed;
+        for(LE::View token : LE::split_view(joined, "icecream")) viewed.push_back(string(token));
+        cout << "\tsplit_view by string - " << (viewed == test_vector) << "\n";
+
+        viewed.clear();
+        for(LE::View token : LE::split_view("* and *y things. <* href='*y*'>!", '*')) viewed.push_back(string(token));
+        cout << "\tsplit_view by char - " << (viewed == test_vector) << "\n";
+
+        const string scanned = ",ab,,c" + string(40, 'x') + ",y," + string(29, 'z') + ",z";
+        LE::CharScan scan;
+        bool scan_ok = true;
+        for(size_t pos = scan.find(scanned, ',', 1), expected = scanned.find(',', 1); scan_ok and expected != string::npos; pos = scan.find(scanned, ',', pos+1), expected = scanned.find(',', expected+1)){
+            scan_ok = (pos == expected);
+        }
+        cout << "\tchar scan - " << (scan_ok and scan.find(scanned, ',', scanned.length()-1) == LE::View::npos) << "\n";
+
+        string appended = "<";
+        LE::join_into(appended, viewed.begin(), viewed.end(), "icecream");
+        cout << "\tjoin_into by string - " << (appended == "<icecream and icecreamy things. <icecream href='icecreamyicecream'>!") << "\n";
+
+        istringstream stream("dirt and dirty things. <dirt href='dirtydirt'>!");
+        LE::StreamTokens stream_tokens(stream, "dirt", 3);
+        vector<string> streamed;
+        for(string token; stream_tokens.next(token); ) streamed.push_back(token);
+        cout << "\tstream split by string - " << (streamed == test_vector) << "\n";
+
         string replaced = LE::replace("dirt and dirty things. <dirt href='dirtydirt'>!", "dirt", "icecream");
         cout << "\treplace - " << (replaced == "icecream and icecreamy things. <icecream href='icecreamyicecream'>!") << "\n";
+        LE::replace_inplace(replaced, "icecream", "dirt");
+        LE::Replacements dirt_to_icecream;
+        dirt_to_icecream.push_back(make_pair("dirt", "icecream"));
+        dirt_to_icecream.push_back(make_pair("dirty", "sweet"));
+        cout << "\treplace all - " << (LE::replace_all("dirt and dirty things. <dirt href='dirtydirt'>!", dirt_to_icecream) == "icecream and sweet things. <icecream href='sweeticecream'>!") << "\n";
+        cout << "\treplace in place - " << (replaced == "dirt and dirty things. <dirt href='dirtydirt'>!") << "\n";
+        LE::replace_inplace(replaced, LE::Pattern("dirty"), '*');
+        cout << "\treplace in place by pattern - " << (replaced == "dirt and * things. <dirt href='*dirt'>!") << "\n";
 
+        string moved = "sweet things for a sunny afternoon: dirt and dirty hands";
+        const char* buffer = moved.data();
+        moved = LE::join(LE::split(LE::replace(std::move(moved), "dirt", '*'), '*'), "mud");
+        cout << "\tsplit, replace and join moved - " << (moved == "sweet things for a sunny afternoon: mud and mudy hands" and moved.data() == buffer) << "\n";
+        vector<string> short_first = LE::split("a," + string(1000, 'b'), ',');
+        cout << "\tsplit moved short first token - " << (short_first.size() == 2 and short_first[0] == "a" and short_first[0].capacity() < 1000) << "\n";
+
+        std::pmr::monotonic_buffer_resource arena;
+        LE::pmr::Strings arena_splitted = LE::pmr::split("dirt and dirty things. <dirt href='dirtydirt'>!", "dirt", &arena);
+        cout << "\tsplit and join in arena - " << (LE::pmr::join(arena_splitted, "icecream", &arena) == "icecream and icecreamy things. <icecream href='icecreamyicecream'>!") << "\n";
+        const LE::Pattern arena_pattern("\r\n");
+        cout << "\treplace with a char in arena - " << (LE::pmr::replace("something something", "thing", '?', &arena) == "some? some?" and LE::pmr::replace("a\r\nb\r\n", arena_pattern, '\n', &arena) == "a\nb\n") << "\n";
+
+        string huge;
+        while(huge.length() < LE::parallel_min_length){
+            huge += "dirt and dirty things. <dirt href='dirtydirt'>!\n";
+        }
+        cout << "\tparallel split and replace - " << (LE::parallel_split(huge, "dirt") == LE::split(huge, "dirt") and LE::parallel_replace(huge, "dirt", "icecream") == LE::replace(huge, "dirt", "icecream")) << "\n";
         cout << "\n +++ text/untext: \n";
         cout << "\ttext - " << (LE::text(123) == "123") << "\n";
+        cout << "\ttext <double> - " << (LE::text(0.1) == "0.1" and LE::text(123456789.0) == "123456789") << "\n";
+        const double numbers[3] = {1.5, 2.0, 0.1};
+        cout << "\ttext array - " << (LE::text(vector<double>(numbers, numbers+3), ',') == "1.5,2,0.1") << "\n";
         cout << "\tuntext <int> - " << (LE::untext<int>("123") == 123) << "\n";
+        int parsed;
+        size_t stopped;
+        cout << "\tuntext into - " << (LE::untext("123", parsed) and parsed == 123 and not LE::untext("12e", parsed, stopped) and stopped == 2) << "\n";
+        vector<double> column;
+        cout << "\tuntext column - " << (LE::untext(LE::split("1.5,2,0.1", ','), column) and LE::text(column, ',') == "1.5,2,0.1") << "\n";
 
         cout << "\n +++ calc: \n";
         cout << "\tcalc - " << (LE::calc("2 * ( 4 + 3.00/ (4+3) ) + (2 - 1) + 1") == "10.84") << "\n";
+        cout << "\tcalc with precision - " << (LE::calc("2 * ( 4 + 3.00/ (4+3) ) + 1", 5) == "9.85714") << "\n";
+        cout << "\tcalc negative - " << (LE::calc("1 - (-3) * -(1 - 3)") == "7") << "\n";
+        cout << "\tcalc past 18 digits - " << (LE::calc("999999999999999999 * 9 / 0.5") == "17999999999999999982.0") << "\n";
+        cout << "\tcalc product scale - " << (LE::calc("8260*8.15/92863") == "0.72" and LE::calc("2.5*0.4/3") == "0.33") << "\n";
+        cout << "\tcalc product trim - " << (LE::calc("1.5*2") == "3" and LE::calc("1.25*4") == "5" and LE::calc("6.8*975") == "6630" and LE::calc("-(0.10*0.10)") == "-0.01" and LE::calc("1.5*2000000000000000000000") == "3000000000000000000000") << "\n";
+        LE::calc_cache(16);
+        bool cached = LE::calc("2 * (4 + 3)") == "14" and LE::calc("2*(4+3)") == "14" and LE::calc("2*(4+3)", 1) == "14";
+        cout << "\tcalc cache - " << (cached and LE::calc_cache_stats().hits == 1 and LE::calc_cache_stats().misses == 2) << "\n";
+        LE::calc_cache(3);
+        for(int i = 0; i < 64; i++){
+            LE::calc(to_string(i) + " + 1");
+        }
+        cout << "\tcalc cache capacity - " << (LE::calc_cache_stats().size == 3 and LE::calc_cache_stats().evictions == 61) << "\n";
+        LE::calc_cache(0);
+        const LE::CalcResult failed = LE::try_calc("2 * (4 + )");
+        cout << "\ttry_calc - " << (LE::try_calc("2 * (4 + 3)").value == "14" and failed.status == LE::calc_syntax_error and failed.offset == 9) << "\n";
+        const string batch[3] = {"1+1", "2/0", "3*3"};
+        vector<LE::CalcResult> results = LE::calc_batch(batch, batch+3);
+        cout << "\tcalc batch - " << (results.size() == 3 and results[0].value == "2" and not results[1].ok() and results[2].value == "9") << "\n";
+        const string nines(600, '9');
+        cout << "\tcalc long - " << (LE::calc(nines + "*" + nines) == string(599, '9') + "8" + string(599, '0') + "1") << "\n";
+        LE::Formula formula = LE::calc_compile("2 * ( x + 3.00/ (x+3) ) + (2 - y) + 1");
+        const string values[2] = {"4", "1"};
+        cout << "\tcalc_compile - " << (formula.evaluate(vector<string>(values, values+2)) == "10.84") << "\n";
+        cout << "\tcalc_compile braced values - " << (formula.evaluate({"4", "1"}) == "10.84" and formula.evaluate_named({{"y", "1"}, {"x", "4"}}) == "10.84") << "\n";
+        const string zero_product[2] = {"-1", "0"};
+        cout << "\tcalc zero product - " << (LE::calc_compile("a*b").evaluate(vector<string>(zero_product, zero_product+2)) == "0" and LE::calc("-1*0*1000000000000000000000") == "0") << "\n";
+
+        cout << "\n +++ stats: \n";
+        LE::stats_reset();
+        LE::calc("2 * ((1 + 3) - 4)");
+        const LE::Stats stats = LE::stats();
+        cout << "\tstats - " << (not stats.enabled or (stats.functions.size() == 8 and stats.calc.max_depth == 2 and stats.calc.numbers == 4)) << "\n";
+        LE::stats_reset();
+        LE::calc("1000000000000000000000 * 3 / 7");
+        LE::join(LE::split("ab,cde", ','), ',');
+        const LE::Stats counted = LE::stats();
+        cout << "\tstats counts only what is called - " << (not counted.enabled or (counted.functions[4].calls == 0 and counted.functions[1].bytes_in == 5)) << "\n";
     }
 }